@@ -6,9 +6,13 @@ import { deflateSync, gunzipSync } from 'node:zlib'
 import { u8 } from '@fuman/utils'
 import { BaseCryptoProvider } from '@mtcute/core/utils.js'
 import {
+  estimateCompressibility,
+  factorizePQ,
   ige256Decrypt,
   ige256Encrypt,
   initSync,
+  isProbablePrime,
+  modPow,
   SIMD_AVAILABLE,
 } from '@mtcute/wasm'
 
@@ -33,6 +37,18 @@ export class BunCryptoProvider extends BaseCryptoProvider implements ICryptoProv
     }
   }
 
+  modPow(base: Uint8Array, exp: Uint8Array, mod: Uint8Array): Uint8Array {
+    return modPow(base, exp, mod)
+  }
+
+  isProbablePrime(n: Uint8Array, rounds: number): boolean {
+    return isProbablePrime(n, buf => this.randomFill(buf), rounds)
+  }
+
+  protected factorizePQNative(pq: Uint8Array): [Uint8Array, Uint8Array] | null {
+    return factorizePQ(pq)
+  }
+
   createAesCtr(key: Uint8Array, iv: Uint8Array): IAesCtr {
     const cipher = createCipheriv(`aes-${key.length * 8}-ctr`, key, iv)
 
@@ -94,6 +110,10 @@ export class BunCryptoProvider extends BaseCryptoProvider implements ICryptoProv
     return gunzipSync(data) as unknown as Uint8Array
   }
 
+  estimateCompressibility(data: Uint8Array): number {
+    return estimateCompressibility(data)
+  }
+
   randomFill(buf: Uint8Array): void {
     crypto.getRandomValues(buf)
   }
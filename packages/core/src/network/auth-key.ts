@@ -6,7 +6,7 @@ import { typed, u8 } from '@fuman/utils'
 
 import { TlBinaryReader } from '@mtcute/tl-runtime'
 import { MtcuteError } from '../types/errors.js'
-import { createAesIgeForMessage } from '../utils/crypto/mtproto.js'
+import { createAesIgeForMessage, sha256Parts } from '../utils/crypto/mtproto.js'
 
 export class AuthKey {
   ready = false
@@ -54,7 +54,7 @@ export class AuthKey {
     buf.set(message, 16)
     this._crypto.randomFill(buf.subarray(16 + message.length, 16 + message.length + padding))
 
-    const messageKey = this._crypto.sha256(u8.concat2(this.clientSalt, buf)).subarray(8, 24)
+    const messageKey = sha256Parts(this._crypto, [this.clientSalt, buf]).subarray(8, 24)
     const ige = createAesIgeForMessage(this._crypto, this.key, messageKey, true)
     const encryptedData = ige.encrypt(buf)
 
@@ -81,7 +81,7 @@ export class AuthKey {
     const ige = createAesIgeForMessage(this._crypto, this.key, messageKey, false)
     const innerData = ige.decrypt(encryptedData)
 
-    const msgKeySource = this._crypto.sha256(u8.concat2(this.serverSalt, innerData))
+    const msgKeySource = sha256Parts(this._crypto, [this.serverSalt, innerData])
     const expectedMessageKey = msgKeySource.subarray(8, 24)
 
     if (!typed.equal(messageKey, expectedMessageKey)) {
@@ -7,6 +7,7 @@ import { TlBinaryReader, TlBinaryWriter, TlSerializationCounter } from '@mtcute/
 import Long from 'long'
 import { mtp } from '../tl/index.js'
 import { MtArgumentError, MtSecurityError, MtTypeAssertionError } from '../types/index.js'
+import { modPow } from '../utils/bigint-utils.js'
 import { findKeyByFingerprints } from '../utils/crypto/keys.js'
 import { millerRabin } from '../utils/crypto/miller-rabin.js'
 import { generateKeyAndIvFromNonce } from '../utils/crypto/mtproto.js'
@@ -155,7 +156,7 @@ function rsaPad(data: Uint8Array, crypto: ICryptoProvider, key: TlPublicKey): Ui
       continue
     }
 
-    const encryptedBigint = bigint.modPowBinary(decryptedDataBigint, keyExponent, keyModulus)
+    const encryptedBigint = modPow(crypto, decryptedDataBigint, keyExponent, keyModulus)
 
     return bigint.toBytes(encryptedBigint, 256)
   }
@@ -169,7 +170,8 @@ function rsaEncrypt(data: Uint8Array, crypto: ICryptoProvider, key: TlPublicKey)
     crypto.randomBytes(235 - data.length),
   )
 
-  const encryptedBigInt = bigint.modPowBinary(
+  const encryptedBigInt = modPow(
+    crypto,
     bigint.fromBytes(toEncrypt),
     BigInt(`0x${key.exponent}`),
     BigInt(`0x${key.modulus}`),
@@ -342,9 +344,9 @@ export async function doAuthorization(
 
   for (;;) {
     const b = bigint.fromBytes(crypto.randomBytes(256))
-    const gB = bigint.modPowBinary(g, b, dhPrime)
+    const gB = modPow(crypto, g, b, dhPrime)
 
-    const authKey = bigint.toBytes(bigint.modPowBinary(gA, b, dhPrime))
+    const authKey = bigint.toBytes(modPow(crypto, gA, b, dhPrime))
     const authKeyAuxHash = crypto.sha1(authKey).subarray(0, 8)
 
     // validate DH params
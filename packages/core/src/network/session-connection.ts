@@ -1543,11 +1543,15 @@ export class SessionConnection extends PersistentConnection {
       // test compression ratio for the middle part
       // if it is less than 0.9, then try to compress the whole request
 
-      const middle = ~~((content.length - 1024) / 2)
-      const middlePart = content.subarray(middle, middle + 1024)
-      const gzipped = this._crypto.gzip(middlePart, Math.floor(middlePart.length * 0.9))
+      if (this._crypto.estimateCompressibility) {
+        shouldGzip = this._crypto.estimateCompressibility(content) < 0.9
+      } else {
+        const middle = ~~((content.length - 1024) / 2)
+        const middlePart = content.subarray(middle, middle + 1024)
+        const gzipped = this._crypto.gzip(middlePart, Math.floor(middlePart.length * 0.9))
 
-      if (!gzipped) shouldGzip = false
+        if (!gzipped) shouldGzip = false
+      }
     }
 
     if (shouldGzip) {
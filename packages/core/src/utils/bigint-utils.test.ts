@@ -1,8 +1,9 @@
 import { bigint } from '@fuman/utils'
 import { defaultTestCryptoProvider } from '@mtcute/test'
-import { describe, expect, it } from 'vitest'
+import { describe, expect, it, vi } from 'vitest'
 
 import {
+  modPow,
   randomBigInt,
   randomBigIntBits,
   randomBigIntInRange,
@@ -63,3 +64,37 @@ describe('randomBigIntInRange', async () => {
     expect(a).toBeLessThan(200n)
   })
 })
+
+describe('modPow', async () => {
+  const c = await defaultTestCryptoProvider()
+  const createProvider = () => {
+    const impl = vi.fn((base: Uint8Array, exp: Uint8Array, mod: Uint8Array) => {
+      const res = bigint.modPowBinary(bigint.fromBytes(base), bigint.fromBytes(exp), bigint.fromBytes(mod))
+
+      return bigint.toBytes(res, mod.length)
+    })
+
+    return [Object.assign(Object.create(c), { modPow: impl }), impl] as const
+  }
+
+  it('should use the provider implementation for odd moduli', () => {
+    const [provider, impl] = createProvider()
+
+    expect(modPow(provider, 4n, 13n, 497n)).toEqual(445n)
+    expect(impl).toHaveBeenCalledOnce()
+  })
+
+  it('should pad exponents smaller than the modulus to its length', () => {
+    const [provider, impl] = createProvider()
+
+    expect(modPow(provider, 4n, 13n, 2n ** 127n - 1n)).toEqual(4n ** 13n)
+    expect(impl.mock.calls[0][1]).toEqual(bigint.toBytes(13n, 16))
+  })
+
+  it('should fall back to bigint arithmetic for even moduli', () => {
+    const [provider, impl] = createProvider()
+
+    expect(modPow(provider, 4n, 13n, 498n)).toEqual(376n)
+    expect(impl).not.toHaveBeenCalled()
+  })
+})
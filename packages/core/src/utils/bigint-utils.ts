@@ -44,3 +44,25 @@ export function randomBigIntInRange(crypto: ICryptoProvider, max: bigint, min =
 
   return min + result
 }
+
+/**
+ * Calculate `base^exp mod mod`, using the crypto provider's implementation if possible
+ *
+ * @param crypto  Crypto provider
+ * @param base  Base
+ * @param exp  Exponent
+ * @param mod  Modulus
+ */
+export function modPow(crypto: ICryptoProvider, base: bigint, exp: bigint, mod: bigint): bigint {
+  if (crypto.modPow && (mod & 1n) === 1n && bigint.bitLength(mod) <= 4096) {
+    const modBytes = bigint.toBytes(mod)
+
+    // DH and SRP exponents are secret. the native implementations take time proportional to the length
+    // of the exponent buffer, so exponents that fit are padded to the length of the modulus to not leak their size
+    const expBytes = exp < mod ? bigint.toBytes(exp, modBytes.length) : bigint.toBytes(exp)
+
+    return bigint.fromBytes(crypto.modPow(bigint.toBytes(base), expBytes, modBytes))
+  }
+
+  return bigint.modPowBinary(base, exp, mod)
+}
@@ -21,6 +21,13 @@ export interface ICryptoProvider {
 
   sha256: (data: Uint8Array) => Uint8Array
 
+  /**
+   * Calculate SHA-256 of the concatenation of `parts`.
+   *
+   * Optional, if not provided `sha256` is called on a concatenated buffer instead
+   */
+  sha256Multi?: (parts: Uint8Array[]) => Uint8Array
+
   pbkdf2: (
     password: Uint8Array,
     salt: Uint8Array,
@@ -31,6 +38,21 @@ export interface ICryptoProvider {
 
   hmacSha256: (data: Uint8Array, key: Uint8Array) => MaybePromise<Uint8Array>
 
+  /**
+   * Calculate `base^exp mod mod`, all numbers are big-endian and the result is padded to the length of `mod`.
+   *
+   * Optional, only used for odd moduli of up to 4096 bits. If not provided, `bigint` arithmetic is used instead
+   */
+  modPow?: (base: Uint8Array, exp: Uint8Array, mod: Uint8Array) => Uint8Array
+
+  /**
+   * Check whether a big-endian number is (probably) prime with `rounds` rounds of the Miller-Rabin test.
+   * Implementations may cache the numbers that were found to be prime.
+   *
+   * Optional, only used for odd numbers of up to 4096 bits. If not provided, `bigint` arithmetic is used instead
+   */
+  isProbablePrime?: (n: Uint8Array, rounds: number) => boolean
+
   createAesCtr: (key: Uint8Array, iv: Uint8Array, encrypt: boolean) => IAesCtr
 
   createAesIge: (key: Uint8Array, iv: Uint8Array) => IEncryptionScheme
@@ -40,6 +62,13 @@ export interface ICryptoProvider {
   gzip: (data: Uint8Array, maxSize: number) => Uint8Array | null
   gunzip: (data: Uint8Array) => Uint8Array
 
+  /**
+   * Estimate the ratio of compressed to original size of `data` (between 0 and 1), without compressing it.
+   *
+   * Optional, if not provided a part of the data is compressed with `gzip` instead
+   */
+  estimateCompressibility?: (data: Uint8Array) => number
+
   randomFill: (buf: Uint8Array) => void
   randomBytes: (size: number) => Uint8Array
 }
@@ -47,8 +76,14 @@ export interface ICryptoProvider {
 export abstract class BaseCryptoProvider {
   abstract randomFill(buf: Uint8Array): void
 
+  /**
+   * Native (e.g. WASM) implementation of `factorizePQ`, used instead of the JS one if available.
+   * Should return `null` if `pq` could not be factorized
+   */
+  protected factorizePQNative?(pq: Uint8Array): [Uint8Array, Uint8Array] | null
+
   factorizePQ(pq: Uint8Array): [Uint8Array, Uint8Array] {
-    return factorizePQSync(this as unknown as ICryptoProvider, pq)
+    return this.factorizePQNative?.(pq) ?? factorizePQSync(this as unknown as ICryptoProvider, pq)
   }
 
   randomBytes(size: number): Uint8Array {
@@ -10,6 +10,11 @@ export function millerRabin(crypto: ICryptoProvider, n: bigint, rounds = 20): bo
   if (n % 2n === 0n || n < 0n) return false
 
   const nBits = bigint.bitLength(n)
+
+  if (crypto.isProbablePrime && nBits <= 4096) {
+    return crypto.isProbablePrime(bigint.toBytes(n), rounds)
+  }
+
   const nSub = n - 1n
 
   const r = bigint.twoMultiplicity(nSub)
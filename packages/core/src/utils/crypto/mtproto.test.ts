@@ -2,7 +2,7 @@ import { hex, u8 } from '@fuman/utils'
 import { defaultTestCryptoProvider } from '@mtcute/test'
 import { beforeEach, describe, expect, it, vi } from 'vitest'
 
-import { createAesIgeForMessage, createAesIgeForMessageOld, generateKeyAndIvFromNonce } from './mtproto.js'
+import { createAesIgeForMessage, createAesIgeForMessageOld, generateKeyAndIvFromNonce, sha256Parts } from './mtproto.js'
 
 const authKeyChunk = hex.decode('98cb29c6ffa89e79da695a54f572e6cb101e81c688b63a4bf73c3622dec230e0')
 const authKey = u8.concat(Array.from({ length: 8 }, () => authKeyChunk))
@@ -82,3 +82,23 @@ describe('mtproto key/iv from nonce', async () => {
     ])
   })
 })
+
+describe('sha256Parts', async () => {
+  const crypto = await defaultTestCryptoProvider()
+  const parts = [hex.decode('0102'), hex.decode(''), hex.decode('030405')]
+  const expected = hex.encode(crypto.sha256(hex.decode('0102030405')))
+
+  it('should use sha256Multi if available', () => {
+    const sha256Multi = vi.fn((parts: Uint8Array[]) => crypto.sha256(u8.concat(parts)))
+    const provider = Object.assign(Object.create(crypto), { sha256Multi })
+
+    expect(hex.encode(sha256Parts(provider, parts))).toEqual(expected)
+    expect(sha256Multi).toHaveBeenCalledWith(parts)
+  })
+
+  it('should fall back to sha256 of the concatenation', () => {
+    const provider = Object.assign(Object.create(crypto), { sha256Multi: undefined })
+
+    expect(hex.encode(sha256Parts(provider, parts))).toEqual(expected)
+  })
+})
@@ -2,6 +2,19 @@ import type { ICryptoProvider, IEncryptionScheme } from './abstract.js'
 
 import { u8 } from '@fuman/utils'
 
+/**
+ * Calculate SHA-256 of the concatenation of `parts`,
+ * avoiding the concatenation if the provider supports it
+ *
+ * @param crypto  Crypto provider
+ * @param parts  Data to hash
+ */
+export function sha256Parts(crypto: ICryptoProvider, parts: Uint8Array[]): Uint8Array {
+  if (crypto.sha256Multi) return crypto.sha256Multi(parts)
+
+  return crypto.sha256(u8.concat(parts))
+}
+
 /**
  * Generate AES key and IV from nonces as defined by MTProto.
  * Used in authorization flow.
@@ -42,8 +55,8 @@ export function createAesIgeForMessage(
   client: boolean,
 ): IEncryptionScheme {
   const x = client ? 0 : 8
-  const sha256a = crypto.sha256(u8.concat2(messageKey, authKey.subarray(x, 36 + x)))
-  const sha256b = crypto.sha256(u8.concat2(authKey.subarray(40 + x, 76 + x), messageKey))
+  const sha256a = sha256Parts(crypto, [messageKey, authKey.subarray(x, 36 + x)])
+  const sha256b = sha256Parts(crypto, [authKey.subarray(40 + x, 76 + x), messageKey])
 
   const key = u8.concat3(sha256a.subarray(0, 8), sha256b.subarray(8, 24), sha256a.subarray(24, 32))
   const iv = u8.concat3(sha256b.subarray(0, 8), sha256a.subarray(8, 24), sha256b.subarray(24, 32))
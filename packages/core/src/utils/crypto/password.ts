@@ -4,6 +4,7 @@ import type { ICryptoProvider } from './abstract.js'
 import { bigint, u8, utf8 } from '@fuman/utils'
 import { MtSecurityError, MtUnsupportedError } from '../../types/errors.js'
 
+import { modPow } from '../bigint-utils.js'
 import { assertTypeIs } from '../type-assertions.js'
 
 /**
@@ -53,7 +54,7 @@ export async function computeNewPasswordHash(
   const p = bigint.fromBytes(algo.p)
   const x = bigint.fromBytes(_x)
 
-  return bigint.toBytes(bigint.modPowBinary(g, x, p), 256)
+  return bigint.toBytes(modPow(crypto, g, x, p), 256)
 }
 
 /**
@@ -94,7 +95,7 @@ export async function computeSrpParams(
   const gB = bigint.fromBytes(request.srpB)
 
   const a = bigint.fromBytes(crypto.randomBytes(256))
-  const gA = bigint.modPowBinary(g, a, p)
+  const gA = modPow(crypto, g, a, p)
   const _gA = bigint.toBytes(gA, 256)
 
   const H = (data: Uint8Array) => crypto.sha256(data)
@@ -106,12 +107,12 @@ export async function computeSrpParams(
   const u = bigint.fromBytes(_u)
   const x = bigint.fromBytes(_x)
 
-  const v = bigint.modPowBinary(g, x, p)
+  const v = modPow(crypto, g, x, p)
   const kV = (k * v) % p
 
   let t = gB - kV
   if (t < 0n) t += p
-  const sA = bigint.modPowBinary(t, a + u * x, p)
+  const sA = modPow(crypto, t, a + u * x, p)
   const _kA = H(bigint.toBytes(sA, 256))
 
   const _M1 = H(u8.concat([
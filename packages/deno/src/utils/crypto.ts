@@ -4,7 +4,16 @@ import { createCipheriv, createHash, createHmac, pbkdf2 } from 'node:crypto'
 
 import { deflateSync, gunzipSync } from 'node:zlib'
 import { BaseCryptoProvider } from '@mtcute/core/utils.js'
-import { getWasmUrl, ige256Decrypt, ige256Encrypt, initSync } from '@mtcute/wasm'
+import {
+  estimateCompressibility,
+  factorizePQ,
+  getWasmUrl,
+  ige256Decrypt,
+  ige256Encrypt,
+  initSync,
+  isProbablePrime,
+  modPow,
+} from '@mtcute/wasm'
 
 // node:crypto is properly implemented in deno, so we can just use it
 // largely just copy-pasting from @mtcute/node
@@ -67,6 +76,18 @@ export class DenoCryptoProvider extends BaseCryptoProvider implements ICryptoPro
     }
   }
 
+  modPow(base: Uint8Array, exp: Uint8Array, mod: Uint8Array): Uint8Array {
+    return modPow(base, exp, mod)
+  }
+
+  isProbablePrime(n: Uint8Array, rounds: number): boolean {
+    return isProbablePrime(n, buf => this.randomFill(buf), rounds)
+  }
+
+  protected factorizePQNative(pq: Uint8Array): [Uint8Array, Uint8Array] | null {
+    return factorizePQ(pq)
+  }
+
   gzip(data: Uint8Array, maxSize: number): Uint8Array | null {
     try {
       // telegram accepts both zlib and gzip, but zlib is faster and has less overhead, so we use it here
@@ -89,6 +110,10 @@ export class DenoCryptoProvider extends BaseCryptoProvider implements ICryptoPro
     return toUint8Array(gunzipSync(data))
   }
 
+  estimateCompressibility(data: Uint8Array): number {
+    return estimateCompressibility(data)
+  }
+
   randomFill(buf: Uint8Array): void {
     crypto.getRandomValues(buf)
   }
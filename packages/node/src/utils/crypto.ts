@@ -5,7 +5,16 @@ import { createRequire } from 'node:module'
 
 import { deflateSync, gunzipSync } from 'node:zlib'
 import { BaseCryptoProvider } from '@mtcute/core/utils.js'
-import { ige256Decrypt, ige256Encrypt, initSync, SIMD_AVAILABLE } from '@mtcute/wasm'
+import {
+  estimateCompressibility,
+  factorizePQ,
+  ige256Decrypt,
+  ige256Encrypt,
+  initSync,
+  isProbablePrime,
+  modPow,
+  SIMD_AVAILABLE,
+} from '@mtcute/wasm'
 
 export class NodeCryptoProvider extends BaseCryptoProvider {
   createAesCtr(key: Uint8Array, iv: Uint8Array): IAesCtr {
@@ -39,6 +48,13 @@ export class NodeCryptoProvider extends BaseCryptoProvider {
     return createHash('sha256').update(data).digest() as Uint8Array
   }
 
+  sha256Multi(parts: Uint8Array[]): Uint8Array {
+    const hash = createHash('sha256')
+    for (const part of parts) hash.update(part)
+
+    return hash.digest() as Uint8Array
+  }
+
   hmacSha256(data: Uint8Array, key: Uint8Array): Uint8Array {
     return createHmac('sha256', key).update(data).digest() as Uint8Array
   }
@@ -63,6 +79,10 @@ export class NodeCryptoProvider extends BaseCryptoProvider {
     return gunzipSync(data) as Uint8Array
   }
 
+  estimateCompressibility(data: Uint8Array): number {
+    return estimateCompressibility(data)
+  }
+
   randomFill(buf: Uint8Array): void {
     randomFillSync(buf)
   }
@@ -85,4 +105,16 @@ export class NodeCryptoProvider extends BaseCryptoProvider {
       },
     }
   }
+
+  modPow(base: Uint8Array, exp: Uint8Array, mod: Uint8Array): Uint8Array {
+    return modPow(base, exp, mod)
+  }
+
+  isProbablePrime(n: Uint8Array, rounds: number): boolean {
+    return isProbablePrime(n, buf => this.randomFill(buf), rounds)
+  }
+
+  protected factorizePQNative(pq: Uint8Array): [Uint8Array, Uint8Array] | null {
+    return factorizePQ(pq)
+  }
 }
@@ -0,0 +1,35 @@
+#include "wasm.h"
+
+#ifndef BIGINT_H
+#define BIGINT_H
+
+// up to 4096-bit moduli
+#define BIGINT_MAX_LIMBS 128
+
+/*
+ * Montgomery arithmetic modulo an odd `m`, on little-endian 32-bit limbs.
+ * Numbers in the Montgomery form are `n` limbs long and are always reduced (< m)
+ */
+struct mont_ctx {
+    uint32_t n; // number of limbs, a multiple of 4
+    uint32_t n0inv; // -m^-1 mod 2^32
+    uint32_t m[BIGINT_MAX_LIMBS];
+    uint32_t one[BIGINT_MAX_LIMBS]; // R mod m, i.e. 1 in the Montgomery form
+};
+
+// `mod` is a big-endian number. returns 0 if it is even, or too large
+int mont_init(struct mont_ctx* ctx, const uint8_t* mod, uint32_t size);
+
+// r = data * R mod m, where `data` is a big-endian number of any length
+void mont_from_bytes(const struct mont_ctx* ctx, uint32_t* r, const uint8_t* data, uint32_t size);
+
+// write a / R mod m to `out` as a big-endian number of `size` bytes
+void mont_to_bytes(const struct mont_ctx* ctx, const uint32_t* a, uint8_t* out, uint32_t size);
+
+// r = a * b / R mod m. `r` may alias `a` or `b`
+void mont_mul(const struct mont_ctx* ctx, uint32_t* r, const uint32_t* a, const uint32_t* b);
+
+// r = a^exp, where `exp` is a big-endian number. `r` may alias `a`
+void mont_pow(const struct mont_ctx* ctx, uint32_t* r, const uint32_t* a, const uint8_t* exp, uint32_t expSize);
+
+#endif // BIGINT_H
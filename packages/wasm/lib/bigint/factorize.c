@@ -0,0 +1,219 @@
+#include "wasm.h"
+
+/*
+ * Factorization of the 64-bit `pq` from the MTProto handshake with Pollard's rho
+ * (Brent's variant), in the Montgomery form modulo n.
+ *
+ * wasm has no 64x64 -> 128 bit multiplication, and __int128 arithmetic would need
+ * compiler-rt, so the high half of the product is computed from 32-bit halves.
+ */
+
+// give up after this many iterations of one attempt (the factors are ~32 bits,
+// so ~2^16 are usually needed)
+#define MAX_ITERATIONS (1 << 22)
+#define MAX_ATTEMPTS 8
+// number of steps between gcd computations
+#define BATCH_SIZE 128
+
+struct pq_mont {
+    uint64_t n;
+    uint64_t ninv; // -n^-1 mod 2^64
+};
+
+WASM_INLINE uint64_t mul_hi64(uint64_t a, uint64_t b) {
+    uint64_t a_lo = (uint32_t) a, a_hi = a >> 32;
+    uint64_t b_lo = (uint32_t) b, b_hi = b >> 32;
+    uint64_t ll = a_lo * b_lo;
+    uint64_t lh = a_lo * b_hi;
+    uint64_t hl = a_hi * b_lo;
+    uint64_t mid = (ll >> 32) + (uint32_t) lh + (uint32_t) hl;
+
+    return a_hi * b_hi + (lh >> 32) + (hl >> 32) + (mid >> 32);
+}
+
+// a * b / 2^64 mod n
+static uint64_t pq_mont_mul(const struct pq_mont* ctx, uint64_t a, uint64_t b) {
+    uint64_t lo = a * b;
+    uint64_t hi = mul_hi64(a, b);
+    uint64_t m = lo * ctx->ninv;
+    // lo + m * n is divisible by 2^64, so its low half only produces a carry, unless lo is 0
+    uint64_t mn_hi = mul_hi64(m, ctx->n) + (lo != 0);
+    uint64_t t = hi + mn_hi;
+
+    // hi, mn_hi < n, so the sum overflows at most once
+    if (t < hi || t >= ctx->n) t -= ctx->n;
+
+    return t;
+}
+
+WASM_INLINE uint64_t pq_add_mod(uint64_t a, uint64_t b, uint64_t n) {
+    uint64_t t = a + b;
+
+    if (t < a || t >= n) t -= n;
+
+    return t;
+}
+
+static uint64_t gcd64(uint64_t a, uint64_t b) {
+    uint32_t shift;
+
+    if (a == 0) return b;
+    if (b == 0) return a;
+
+    shift = __builtin_ctzll(a | b);
+    a >>= __builtin_ctzll(a);
+
+    do {
+        b >>= __builtin_ctzll(b);
+
+        if (a > b) {
+            uint64_t t = a;
+            a = b;
+            b = t;
+        }
+
+        b -= a;
+    } while (b != 0);
+
+    return a << shift;
+}
+
+static uint64_t pq_mont_pow(const struct pq_mont* ctx, uint64_t a, uint64_t e, uint64_t one) {
+    uint64_t r = one;
+
+    for (; e != 0; e >>= 1) {
+        if (e & 1) r = pq_mont_mul(ctx, r, a);
+        a = pq_mont_mul(ctx, a, a);
+    }
+
+    return r;
+}
+
+// deterministic miller-rabin, these bases are enough for any 64-bit number.
+// rho would never finish for a prime, so it is checked upfront
+static int is_prime64(const struct pq_mont* ctx) {
+    static const uint8_t bases[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37 };
+    const uint64_t n = ctx->n;
+    uint64_t one = (0 - n) % n; // 2^64 mod n
+    uint64_t minus_one = n - one;
+    uint64_t r2 = one, d = n - 1, x;
+    uint32_t s, i, j;
+
+    for (i = 0; i < 64; i++) {
+        r2 = pq_add_mod(r2, r2, n);
+    }
+
+    s = __builtin_ctzll(d);
+    d >>= s;
+
+    for (i = 0; i < sizeof(bases); i++) {
+        if (n == bases[i]) return 1;
+        if (n % bases[i] == 0) return 0;
+
+        x = pq_mont_pow(ctx, pq_mont_mul(ctx, bases[i], r2), d, one);
+        if (x == one || x == minus_one) continue;
+
+        for (j = 1; j < s && x != minus_one; j++) {
+            x = pq_mont_mul(ctx, x, x);
+        }
+
+        if (x != minus_one) return 0;
+    }
+
+    return 1;
+}
+
+// find a non-trivial divisor of odd n, or return 0
+static uint64_t pollard_brent(const struct pq_mont* ctx, uint64_t c) {
+    const uint64_t n = ctx->n;
+    uint64_t x = 0, y = 2, ys = 2, q = 1, g = 1;
+    uint64_t r, i, k, steps;
+
+    for (r = 1; g == 1; r <<= 1) {
+        if (r > MAX_ITERATIONS) return 0;
+
+        x = y;
+        for (i = 0; i < r; i++) {
+            y = pq_add_mod(pq_mont_mul(ctx, y, y), c, n);
+        }
+
+        for (k = 0; k < r && g == 1; k += BATCH_SIZE) {
+            ys = y;
+            steps = MIN(BATCH_SIZE, r - k);
+
+            for (i = 0; i < steps; i++) {
+                y = pq_add_mod(pq_mont_mul(ctx, y, y), c, n);
+                // the product is in the Montgomery form, which doesn't change its gcd with n
+                q = pq_mont_mul(ctx, q, x > y ? x - y : y - x);
+            }
+
+            g = gcd64(q, n);
+        }
+    }
+
+    // the batch overshot the cycle, redo it one step at a time
+    if (g == n) {
+        do {
+            ys = pq_add_mod(pq_mont_mul(ctx, ys, ys), c, n);
+            g = gcd64(x > ys ? x - ys : ys - x, n);
+        } while (g == 1);
+    }
+
+    return g == n ? 0 : g;
+}
+
+/*
+ * Factorize `pq` (a big-endian number of up to 8 bytes) into `p` and `q`, p <= q.
+ * Both are written to `out` as 8-byte big-endian numbers.
+ * Returns 0 if `pq` is too large, is a prime, or no divisor was found
+ */
+WASM_EXPORT int factorize_pq(const uint8_t* pq, uint32_t size, uint8_t* out) {
+    struct pq_mont ctx;
+    uint64_t n = 0, p = 0, inv;
+    uint32_t i;
+
+    while (size != 0 && pq[0] == 0) {
+        pq++;
+        size--;
+    }
+
+    if (size > 8) return 0;
+
+    for (i = 0; i < size; i++) {
+        n = (n << 8) | pq[i];
+    }
+
+    if (n < 4) return 0;
+
+    if ((n & 1) == 0) {
+        p = 2;
+    } else {
+        ctx.n = n;
+
+        // newton's iteration, every step doubles the number of correct low bits
+        inv = n;
+        for (i = 0; i < 5; i++) {
+            inv *= 2 - n * inv;
+        }
+        ctx.ninv = 0 - inv;
+
+        if (is_prime64(&ctx)) return 0;
+
+        for (i = 1; i <= MAX_ATTEMPTS && p == 0; i++) {
+            p = pollard_brent(&ctx, i % n);
+        }
+
+        if (p == 0) return 0;
+    }
+
+    if (p > n / p) p = n / p;
+
+    store_u64_unaligned(be64_bswap(p), out);
+    store_u64_unaligned(be64_bswap(n / p), out + 8);
+
+    return 1;
+}
+
+#undef MAX_ITERATIONS
+#undef MAX_ATTEMPTS
+#undef BATCH_SIZE
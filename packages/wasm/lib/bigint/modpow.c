@@ -0,0 +1,26 @@
+#include "bigint/bigint.h"
+
+// out = base^exp mod mod, written as a big-endian number of `modSize` bytes.
+// returns -1 if the modulus is even or too large
+WASM_EXPORT int modpow(
+    const uint8_t* base,
+    uint32_t baseSize,
+    const uint8_t* exp,
+    uint32_t expSize,
+    const uint8_t* mod,
+    uint32_t modSize,
+    uint8_t* out
+) {
+    struct mont_ctx ctx;
+    uint32_t r[BIGINT_MAX_LIMBS];
+
+    if (!mont_init(&ctx, mod, modSize)) return -1;
+
+    mont_from_bytes(&ctx, r, base, baseSize);
+    mont_pow(&ctx, r, r, exp, expSize);
+    mont_to_bytes(&ctx, r, out, modSize);
+
+    memset(r, 0, sizeof(r));
+
+    return 0;
+}
@@ -0,0 +1,258 @@
+#include "bigint/bigint.h"
+#include <stdalign.h>
+
+/*
+ * Montgomery multiplication and exponentiation.
+ *
+ * Conditional steps (final subtractions, window table lookups) are done with masks
+ * instead of branches, since the exponent is often a secret (DH and SRP private values).
+ */
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+#define WINDOW_BITS 4
+#define WINDOW_SIZE (1 << WINDOW_BITS)
+
+// r = t - m if t (with `hi` as an extra top limb) is >= m, t otherwise
+static void mont_reduce_once(const struct mont_ctx* ctx, uint32_t* r, const uint32_t* t, uint32_t hi) {
+    uint32_t d[BIGINT_MAX_LIMBS];
+    uint32_t borrow = 0, mask;
+    uint64_t x;
+    uint32_t i;
+
+    for (i = 0; i < ctx->n; i++) {
+        x = (uint64_t) t[i] - ctx->m[i] - borrow;
+        d[i] = (uint32_t) x;
+        borrow = (uint32_t) (x >> 63);
+    }
+
+    // keep the difference if it didn't underflow, or if the top limb was set
+    mask = 0 - (hi | (borrow ^ 1));
+
+    for (i = 0; i < ctx->n; i++) {
+        r[i] = (d[i] & mask) | (t[i] & ~mask);
+    }
+}
+
+// r = 2r + bit mod m, r < m
+static void mod_double_add(const struct mont_ctx* ctx, uint32_t* r, uint32_t bit) {
+    uint32_t carry = bit, next;
+    uint32_t i;
+
+    for (i = 0; i < ctx->n; i++) {
+        next = r[i] >> 31;
+        r[i] = (r[i] << 1) | carry;
+        carry = next;
+    }
+
+    mont_reduce_once(ctx, r, r, carry);
+}
+
+int mont_init(struct mont_ctx* ctx, const uint8_t* mod, uint32_t size) {
+    uint32_t inv, limbs, i;
+
+    while (size != 0 && mod[0] == 0) {
+        mod++;
+        size--;
+    }
+
+    if (size == 0 || (mod[size - 1] & 1) == 0) return 0;
+
+    limbs = (size + 3) / 4;
+    ctx->n = (limbs + 3) & ~3;
+    if (ctx->n > BIGINT_MAX_LIMBS) return 0;
+
+    memset(ctx->m, 0, ctx->n * 4);
+    for (i = 0; i < size; i++) {
+        ctx->m[i / 4] |= (uint32_t) mod[size - 1 - i] << (i % 4 * 8);
+    }
+
+    // newton's iteration, every step doubles the number of correct low bits (m * m = 1 mod 8 for odd m)
+    inv = ctx->m[0];
+    for (i = 0; i < 4; i++) {
+        inv *= 2 - ctx->m[0] * inv;
+    }
+    ctx->n0inv = 0 - inv;
+
+    // R mod m = 1 << 32n mod m
+    memset(ctx->one, 0, ctx->n * 4);
+    mod_double_add(ctx, ctx->one, 1);
+    for (i = 0; i < ctx->n * 32; i++) {
+        mod_double_add(ctx, ctx->one, 0);
+    }
+
+    return 1;
+}
+
+void mont_from_bytes(const struct mont_ctx* ctx, uint32_t* r, const uint8_t* data, uint32_t size) {
+    uint32_t i;
+    int bit;
+
+    memset(r, 0, ctx->n * 4);
+
+    // reduce the number bit by bit, and then shift it by R. only done once per input,
+    // so the cost is negligible compared to the multiplications that follow
+    for (i = 0; i < size; i++) {
+        for (bit = 7; bit >= 0; bit--) {
+            mod_double_add(ctx, r, (data[i] >> bit) & 1);
+        }
+    }
+
+    for (i = 0; i < ctx->n * 32; i++) {
+        mod_double_add(ctx, r, 0);
+    }
+}
+
+void mont_to_bytes(const struct mont_ctx* ctx, const uint32_t* a, uint8_t* out, uint32_t size) {
+    uint32_t t[BIGINT_MAX_LIMBS];
+    uint32_t i;
+
+    memset(t, 0, ctx->n * 4);
+    t[0] = 1;
+    mont_mul(ctx, t, a, t);
+
+    for (i = 0; i < size; i++) {
+        out[size - 1 - i] = i < ctx->n * 4 ? (uint8_t) (t[i / 4] >> (i % 4 * 8)) : 0;
+    }
+}
+
+#ifdef __wasm_simd128__
+
+/*
+ * Products are split into their low and high halves, which are accumulated separately
+ * into 64-bit columns without propagating carries (each column receives at most 2^9
+ * 32-bit values, so it can't overflow). This way, 4 limbs of both `a * b[i]` and `q * m`
+ * are processed at once with u32x4 -> u64x2 extended multiplications, and the carries
+ * are resolved once per row, only for the column that is being shifted out.
+ */
+void mont_mul(const struct mont_ctx* ctx, uint32_t* r, const uint32_t* a, const uint32_t* b) {
+    // lo[k] and hi[k] both have the weight of limb k
+    alignas(16) uint64_t lo[BIGINT_MAX_LIMBS * 2];
+    alignas(16) uint64_t hi[BIGINT_MAX_LIMBS * 2];
+    uint32_t t[BIGINT_MAX_LIMBS];
+    const uint32_t n = ctx->n;
+    const v128_t mask = wasm_i64x2_splat(0xffffffff);
+    v128_t bi, q, av, mv, p0, p1, p2, p3;
+    uint64_t carry = 0, x;
+    uint32_t i, j;
+
+    memset(lo, 0, n * 2 * 8);
+    memset(hi, 0, n * 2 * 8);
+
+    for (i = 0; i < n; i++) {
+        // low 32 bits of column i after adding a[0] * b[i] decide the multiple of m to add
+        // (the sum may wrap around, but only its low bits matter here)
+        x = lo[i] + hi[i] + carry + (uint64_t) a[0] * b[i];
+        q = wasm_i32x4_splat((uint32_t) x * ctx->n0inv);
+        bi = wasm_i32x4_splat(b[i]);
+
+        for (j = 0; j < n; j += 4) {
+            av = wasm_v128_load(&a[j]);
+            mv = wasm_v128_load(&ctx->m[j]);
+
+            p0 = wasm_u64x2_extmul_low_u32x4(av, bi);
+            p1 = wasm_u64x2_extmul_high_u32x4(av, bi);
+            p2 = wasm_u64x2_extmul_low_u32x4(mv, q);
+            p3 = wasm_u64x2_extmul_high_u32x4(mv, q);
+
+            wasm_v128_store(&lo[i + j], wasm_i64x2_add(wasm_v128_load(&lo[i + j]),
+                wasm_i64x2_add(wasm_v128_and(p0, mask), wasm_v128_and(p2, mask))));
+            wasm_v128_store(&lo[i + j + 2], wasm_i64x2_add(wasm_v128_load(&lo[i + j + 2]),
+                wasm_i64x2_add(wasm_v128_and(p1, mask), wasm_v128_and(p3, mask))));
+            wasm_v128_store(&hi[i + j + 1], wasm_i64x2_add(wasm_v128_load(&hi[i + j + 1]),
+                wasm_i64x2_add(wasm_u64x2_shr(p0, 32), wasm_u64x2_shr(p2, 32))));
+            wasm_v128_store(&hi[i + j + 3], wasm_i64x2_add(wasm_v128_load(&hi[i + j + 3]),
+                wasm_i64x2_add(wasm_u64x2_shr(p1, 32), wasm_u64x2_shr(p3, 32))));
+        }
+
+        // column i is now divisible by 2^32
+        carry = (lo[i] + hi[i] + carry) >> 32;
+    }
+
+    for (i = 0; i < n; i++) {
+        x = lo[n + i] + hi[n + i] + carry;
+        t[i] = (uint32_t) x;
+        carry = x >> 32;
+    }
+
+    mont_reduce_once(ctx, r, t, (uint32_t) carry);
+}
+
+#else
+
+// CIOS (coarsely integrated operand scanning) method, with both inner loops fused into one:
+// the two carry chains are independent, and `t` is only traversed once per row
+void mont_mul(const struct mont_ctx* ctx, uint32_t* r, const uint32_t* a, const uint32_t* b) {
+    uint32_t t[BIGINT_MAX_LIMBS + 1];
+    const uint32_t n = ctx->n;
+    uint64_t c1, c2;
+    uint32_t q, i, j;
+
+    memset(t, 0, (n + 1) * 4);
+
+    for (i = 0; i < n; i++) {
+        c1 = t[0] + (uint64_t) a[0] * b[i];
+        q = (uint32_t) c1 * ctx->n0inv;
+        c2 = (uint32_t) c1 + (uint64_t) q * ctx->m[0];
+
+        for (j = 1; j < n; j++) {
+            c1 = t[j] + (uint64_t) a[j] * b[i] + (c1 >> 32);
+            c2 = (uint32_t) c1 + (uint64_t) q * ctx->m[j] + (c2 >> 32);
+            t[j - 1] = (uint32_t) c2;
+        }
+
+        c1 = t[n] + (c1 >> 32) + (c2 >> 32);
+        t[n - 1] = (uint32_t) c1;
+        t[n] = (uint32_t) (c1 >> 32);
+    }
+
+    mont_reduce_once(ctx, r, t, t[n]);
+}
+
+#endif
+
+// fixed window exponentiation: every window (including leading zero ones) costs the same
+// number of multiplications, so the running time depends on `expSize` but not on the exponent bits.
+// callers that need to hide the length of a secret exponent should pad it with zero bytes.
+// the window table is on the stack (8 KB at most), so this can't fail
+void mont_pow(const struct mont_ctx* ctx, uint32_t* r, const uint32_t* a, const uint8_t* exp, uint32_t expSize) {
+    const uint32_t n = ctx->n;
+    uint32_t table[WINDOW_SIZE * BIGINT_MAX_LIMBS];
+    uint32_t sel[BIGINT_MAX_LIMBS];
+    uint32_t i, j, k, window, mask;
+
+    memcpy(table, ctx->one, n * 4);
+    memcpy(table + n, a, n * 4);
+    for (k = 2; k < WINDOW_SIZE; k++) {
+        mont_mul(ctx, table + k * n, table + (k - 1) * n, a);
+    }
+
+    memcpy(r, ctx->one, n * 4);
+
+    for (i = 0; i < expSize * 2; i++) {
+        window = (exp[i / 2] >> (i % 2 == 0 ? 4 : 0)) & 0xf;
+
+        // squaring the initial 1 is wasted work, but skipping it would leak the position of the top bit
+        for (k = 0; k < WINDOW_BITS; k++) {
+            mont_mul(ctx, r, r, r);
+        }
+
+        // table[window], without a data-dependent memory access
+        memset(sel, 0, n * 4);
+        for (k = 0; k < WINDOW_SIZE; k++) {
+            mask = 0 - (uint32_t) (k == window);
+            for (j = 0; j < n; j++) {
+                sel[j] |= table[k * n + j] & mask;
+            }
+        }
+
+        mont_mul(ctx, r, r, sel);
+    }
+
+    memset(table, 0, WINDOW_SIZE * n * 4);
+}
+
+#undef WINDOW_BITS
+#undef WINDOW_SIZE
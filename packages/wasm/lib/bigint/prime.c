@@ -0,0 +1,174 @@
+#include "bigint/bigint.h"
+#include "hash/sha256.h"
+
+/*
+ * Miller-Rabin primality test, with a cache of numbers that passed it.
+ *
+ * The same DH primes are checked over and over (for every new auth key, on every DC,
+ * for every account), so numbers that were found to be prime are remembered by their
+ * SHA-256 hash for the lifetime of the module. The number of rounds they passed is stored
+ * along with the hash, so a cached result is only reused for requests with as many rounds or fewer.
+ */
+
+#define PRIME_CACHE_SIZE 16
+
+struct prime_cache_entry {
+    uint8_t hash[SHA256_DIGEST_SIZE];
+    uint32_t rounds;
+};
+
+static struct prime_cache_entry prime_cache[PRIME_CACHE_SIZE];
+static uint32_t prime_cache_count = 0;
+static uint32_t prime_cache_next = 0;
+
+static struct prime_cache_entry* prime_cache_find(const uint8_t* hash) {
+    uint32_t i, j;
+    uint8_t diff;
+
+    for (i = 0; i < prime_cache_count; i++) {
+        diff = 0;
+        for (j = 0; j < SHA256_DIGEST_SIZE; j++) {
+            diff |= prime_cache[i].hash[j] ^ hash[j];
+        }
+
+        if (diff == 0) return &prime_cache[i];
+    }
+
+    return NULL;
+}
+
+static void prime_cache_add(const uint8_t* hash, uint32_t rounds) {
+    memcpy(prime_cache[prime_cache_next].hash, hash, SHA256_DIGEST_SIZE);
+    prime_cache[prime_cache_next].rounds = rounds;
+    prime_cache_next = (prime_cache_next + 1) % PRIME_CACHE_SIZE;
+    if (prime_cache_count < PRIME_CACHE_SIZE) prime_cache_count++;
+}
+
+static int limbs_zero(const uint32_t* a, uint32_t n) {
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+        if (a[i] != 0) return 0;
+    }
+
+    return 1;
+}
+
+static int limbs_equal(const uint32_t* a, const uint32_t* b, uint32_t n) {
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+        if (a[i] != b[i]) return 0;
+    }
+
+    return 1;
+}
+
+static int miller_rabin(
+    const uint8_t* num,
+    uint32_t size,
+    const uint8_t* random,
+    uint32_t randomStride,
+    uint32_t rounds
+) {
+    struct mont_ctx mont;
+    struct mont_ctx* ctx = &mont;
+    uint8_t d[BIGINT_MAX_LIMBS * 4];
+    uint32_t minus_one[BIGINT_MAX_LIMBS];
+    uint32_t x[BIGINT_MAX_LIMBS];
+    uint32_t s = 0, i, j, n;
+    uint64_t borrow = 0;
+    int result = 1;
+
+    mont_init(ctx, num, size);
+    n = ctx->n;
+
+    // -1 in the Montgomery form is m - R mod m
+    for (i = 0; i < n; i++) {
+        borrow = (uint64_t) ctx->m[i] - ctx->one[i] - (uint32_t) (borrow >> 63);
+        minus_one[i] = (uint32_t) borrow;
+    }
+
+    // num - 1 = d * 2^s. num is odd, so subtracting one only clears the lowest bit
+    memcpy(d, num, size);
+    d[size - 1] &= 0xfe;
+
+    while (d[size - 1 - s / 8] == 0) s += 8;
+    s += __builtin_ctz(d[size - 1 - s / 8]);
+
+    for (i = size; i-- > 0;) {
+        j = i - s / 8;
+        d[i] = (j < size ? d[j] >> (s % 8) : 0)
+            | (s % 8 != 0 && j - 1 < size ? (uint8_t) (d[j - 1] << (8 - s % 8)) : 0);
+    }
+
+    for (i = 0; i < rounds && result; i++, random += randomStride) {
+        // random base, reduced modulo num. 0 and +-1 would always pass, skip them
+        mont_from_bytes(ctx, x, random, randomStride);
+        if (limbs_zero(x, n) || limbs_equal(x, ctx->one, n) || limbs_equal(x, minus_one, n)) continue;
+
+        mont_pow(ctx, x, x, d, size);
+        if (limbs_equal(x, ctx->one, n) || limbs_equal(x, minus_one, n)) continue;
+
+        result = 0;
+        for (j = 1; j < s; j++) {
+            mont_mul(ctx, x, x, x);
+
+            if (limbs_equal(x, minus_one, n)) {
+                result = 1;
+                break;
+            }
+
+            if (limbs_equal(x, ctx->one, n)) break;
+        }
+    }
+
+    return result;
+}
+
+/*
+ * Check whether a big-endian number is (probably) prime.
+ * `random` contains `rounds` random numbers of `size` bytes, used as the bases.
+ *
+ * Returns 1 if the number is probably prime (or was found to be prime before with at least `rounds` rounds),
+ * 0 if it is composite, -1 if it is not cached and `random` is NULL,
+ * -2 if it is longer than 4096 bits
+ */
+WASM_EXPORT int is_probable_prime(const uint8_t* num, uint32_t size, const uint8_t* random, uint32_t rounds) {
+    struct lekkit_sha256_buff sha;
+    struct prime_cache_entry* cached;
+    uint8_t hash[SHA256_DIGEST_SIZE];
+    uint32_t stride = size;
+
+    while (size != 0 && num[0] == 0) {
+        num++;
+        size--;
+    }
+
+    if (size > BIGINT_MAX_LIMBS * 4) return -2;
+
+    // 0, 1, 2, 3 and even numbers
+    if (size == 0 || (size == 1 && num[0] < 4)) return size == 1 && num[0] > 1;
+    if ((num[size - 1] & 1) == 0) return 0;
+
+    lekkit_sha256_init(&sha);
+    lekkit_sha256_update(&sha, num, size);
+    lekkit_sha256_finalize(&sha);
+    lekkit_sha256_read(&sha, hash);
+
+    cached = prime_cache_find(hash);
+    if (cached != NULL && cached->rounds >= rounds) return 1;
+    if (random == NULL) return -1;
+
+    if (!miller_rabin(num, size, random, stride, rounds)) return 0;
+
+    if (cached != NULL) {
+        cached->rounds = rounds;
+    } else {
+        prime_cache_add(hash, rounds);
+    }
+
+    return 1;
+}
+
+#undef PRIME_CACHE_SIZE
@@ -15,6 +15,8 @@ WASM_EXPORT uint8_t* __get_shared_iv_buffer() {
   return aes_shared_iv_buffer;
 }
 
+#ifndef AES256_VPAES
+
 static const uint32_t Te0[256] = {
     0xc66363a5, 0xf87c7c84, 0xee777799, 0xf67b7b8d, 0xfff2f20d, 0xd66b6bbd, 0xde6f6fb1, 0x91c5c554,
     0x60303050, 0x02010103, 0xce6767a9, 0x562b2b7d, 0xe7fefe19, 0xb5d7d762, 0x4dababe6, 0xec76769a,
@@ -621,3 +623,12 @@ v16qi aes256_decrypt(v16qi in, uint32_t* key) {
 
     return (v16qi)v4_out;
 }
+
+void aes256_encrypt_x4(v16qi* blocks, uint32_t* expandedKey) {
+    blocks[0] = aes256_encrypt(blocks[0], expandedKey);
+    blocks[1] = aes256_encrypt(blocks[1], expandedKey);
+    blocks[2] = aes256_encrypt(blocks[2], expandedKey);
+    blocks[3] = aes256_encrypt(blocks[3], expandedKey);
+}
+
+#endif // AES256_VPAES
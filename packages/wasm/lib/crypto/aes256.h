@@ -4,11 +4,21 @@
 #ifndef AES256_H
 #define AES256_H
 
+// the SIMD build uses a constant-time vector permute implementation (see aes256_vpaes.c)
+// instead of the T-tables. both use the same expanded key size, but not the same layout
+#ifdef __wasm_simd128__
+#define AES256_VPAES
+#endif
+
 #define AES_BLOCK_SIZE 16
 #define EXPANDED_KEY_SIZE 60
 
 typedef uint8_t v16qi __attribute__ (( vector_size(16) ));
 typedef uint32_t v4si __attribute__ (( vector_size(16) ));
+typedef uint64_t v2di __attribute__ (( vector_size(16) ));
+
+// same as v16qi, but safe to load from/store to unaligned addresses
+typedef uint8_t v16qi_u __attribute__ (( vector_size(16), aligned(1) ));
 
 extern alignas(16) uint8_t aes_shared_key_buffer[32];
 extern alignas(16) uint8_t aes_shared_iv_buffer[32];
@@ -19,4 +29,11 @@ void aes256_set_decryption_key(uint8_t* key, uint32_t* expandedKey);
 v16qi aes256_encrypt(v16qi in, uint32_t* expandedKey);
 v16qi aes256_decrypt(v16qi in, uint32_t* expandedKey);
 
+// encrypt 4 independent blocks in place
+void aes256_encrypt_x4(v16qi* blocks, uint32_t* expandedKey);
+
+// AES-IGE with an explicit 32-byte key and 32-byte iv (see ige256.c)
+void aes256_ige_encrypt(uint8_t* in, uint32_t length, uint8_t* out, uint8_t* key, uint8_t* iv);
+void aes256_ige_decrypt(uint8_t* in, uint32_t length, uint8_t* out, uint8_t* key, uint8_t* iv);
+
 #endif  // AES256_H
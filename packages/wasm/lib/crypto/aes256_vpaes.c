@@ -0,0 +1,344 @@
+/*
+ * Constant-time AES-256 for the SIMD build, based on the vector permutation
+ * technique by Mike Hamburg ("Accelerating AES with Vector Permute Instructions",
+ * CHES 2009, public domain), with pshufb replaced by i8x16.swizzle.
+ *
+ * The state is kept in a transformed basis where the S-box can be computed with
+ * 4-bit table lookups done entirely in registers, so there are no secret-dependent
+ * memory accesses. Constants are the same as in OpenSSL's vpaes.
+ *
+ * i8x16.swizzle zeroes lanes with index >= 16, while pshufb only looks at the
+ * high bit. All indices produced here are either in 0..15 or 0x80..0x8f,
+ * so both behave identically.
+ */
+
+#include "aes256.h"
+
+#ifdef AES256_VPAES
+
+#include <wasm_simd128.h>
+
+#define VPAES_ROUNDS 14
+
+alignas(16) static const uint64_t k_inv[4] = {
+    0x0E05060F0D080180, 0x040703090A0B0C02, // inv
+    0x01040A060F0B0780, 0x030D0E0C02050809, // inva
+};
+
+alignas(16) static const uint64_t k_ipt[4] = {
+    0xC2B2E8985A2A7000, 0xCABAE09052227808,
+    0x4C01307D317C4D00, 0xCD80B1FCB0FDCC81,
+};
+
+alignas(16) static const uint64_t k_sb1[4] = {
+    0xB19BE18FCB503E00, 0xA5DF7A6E142AF544,
+    0x3618D415FAE22300, 0x3BF7CCC10D2ED9EF,
+};
+
+alignas(16) static const uint64_t k_sb2[4] = {
+    0xE27A93C60B712400, 0x5EB7E955BC982FCD,
+    0x69EB88400AE12900, 0xC2A163C8AB82234A,
+};
+
+alignas(16) static const uint64_t k_sbo[4] = {
+    0xD0D26D176FBDC700, 0x15AABF7AC502A878,
+    0xCFE474A55FBB6A00, 0x8E1E90D1412B35FA,
+};
+
+alignas(16) static const uint64_t k_mc_forward[8] = {
+    0x0407060500030201, 0x0C0F0E0D080B0A09,
+    0x080B0A0904070605, 0x000302010C0F0E0D,
+    0x0C0F0E0D080B0A09, 0x0407060500030201,
+    0x000302010C0F0E0D, 0x080B0A0904070605,
+};
+
+alignas(16) static const uint64_t k_mc_backward[8] = {
+    0x0605040702010003, 0x0E0D0C0F0A09080B,
+    0x020100030E0D0C0F, 0x0A09080B06050407,
+    0x0E0D0C0F0A09080B, 0x0605040702010003,
+    0x0A09080B06050407, 0x020100030E0D0C0F,
+};
+
+alignas(16) static const uint64_t k_sr[8] = {
+    0x0706050403020100, 0x0F0E0D0C0B0A0908,
+    0x030E09040F0A0500, 0x0B06010C07020D08,
+    0x0F060D040B020900, 0x070E050C030A0108,
+    0x0B0E0104070A0D00, 0x0306090C0F020508,
+};
+
+alignas(16) static const uint64_t k_rcon[2] = {
+    0x1F8391B9AF9DEEB6, 0x702A98084D7C7D81,
+};
+
+alignas(16) static const uint64_t k_s63[2] = {
+    0x5B5B5B5B5B5B5B5B, 0x5B5B5B5B5B5B5B5B,
+};
+
+alignas(16) static const uint64_t k_opt[4] = {
+    0xFF9F4929D6B66000, 0xF7974121DEBE6808,
+    0x01EDBD5150BCEC00, 0xE10D5DB1B05C0CE0,
+};
+
+alignas(16) static const uint64_t k_deskew[4] = {
+    0x07E4A34047A4E300, 0x1DFEB95A5DBEF91A,
+    0x5F36B5DC83EA6900, 0x2841C2ABF49D1E77,
+};
+
+// decryption key schedule: invskew x*D, x*B, x*E + 0x63, x*9
+alignas(16) static const uint64_t k_dks[16] = {
+    0xFEB91A5DA3E44700, 0x0740E3A45A1DBEF9,
+    0x41C277F4B5368300, 0x5FDC69EAAB289D1E,
+    0x9A4FCA1F8550D500, 0x03D653861CC94C99,
+    0x115BEDA7B6FC4A00, 0xD993256F7E3482C8,
+    0xD5031CCA1FC9D600, 0x53859A4C994F5086,
+    0xA23196054FDC7BE8, 0xCD5EF96A20B31487,
+    0xB6116FC87ED9A700, 0x4AED933482255BFC,
+    0x4576516227143300, 0x8BB89FACE9DAFDCE,
+};
+
+alignas(16) static const uint64_t k_dipt[4] = {
+    0x0F505B040B545F00, 0x154A411E114E451A,
+    0x86E383E660056500, 0x12771772F491F194,
+};
+
+// decryption S-box outputs: *9, *D, *B, *E, and the final round
+alignas(16) static const uint64_t k_dsb[20] = {
+    0x851C03539A86D600, 0xCAD51F504F994CC9,
+    0xC03B1789ECD74900, 0x725E2C9EB2FBA565,
+    0x7D57CCDFE6B1A200, 0xF56E9B13882A4439,
+    0x3CE2FAF724C6CB00, 0x2931180D15DEEFD3,
+    0xD022649296B44200, 0x602646F6B0F2D404,
+    0xC19498A6CD596700, 0xF3FF0C3E3255AA6B,
+    0x46F2929626D4D000, 0x2242600464B4F6B0,
+    0x0C55A6CDFFAAC100, 0x9467F36B98593E32,
+    0x1387EA537EF94000, 0xC7AA6DB9D4943E2D,
+    0x12D7560F93441D00, 0xCA4B8159D8C58E9C,
+};
+
+#define K(table, i) wasm_v128_load(&(table)[(i) * 2])
+#define SWIZZLE(table, idx) wasm_i8x16_swizzle(table, idx)
+
+// lookup of the low and high nibbles of `x` in a pair of tables, xored together
+WASM_INLINE v128_t vpaes_transform(v128_t x, const uint64_t* table) {
+    v128_t hi = wasm_u8x16_shr(x, 4);
+    v128_t lo = wasm_v128_and(x, wasm_i8x16_splat(0x0f));
+
+    return wasm_v128_xor(SWIZZLE(K(table, 0), lo), SWIZZLE(K(table, 1), hi));
+}
+
+// common top of the round: inversion in GF(2^4)^2, producing the io/jo indices
+// for the output tables
+WASM_INLINE void vpaes_sbox_in(v128_t x, v128_t* io, v128_t* jo) {
+    v128_t inv = K(k_inv, 0);
+    v128_t i = wasm_u8x16_shr(x, 4);
+    v128_t k = wasm_v128_and(x, wasm_i8x16_splat(0x0f));
+    v128_t ak = SWIZZLE(K(k_inv, 1), k);
+    v128_t j = wasm_v128_xor(i, k);
+    v128_t iak = wasm_v128_xor(SWIZZLE(inv, i), ak);
+    v128_t jak = wasm_v128_xor(SWIZZLE(inv, j), ak);
+
+    *io = wasm_v128_xor(SWIZZLE(inv, iak), j);
+    *jo = wasm_v128_xor(SWIZZLE(inv, jak), i);
+}
+
+WASM_INLINE v128_t vpaes_sbox_out(const uint64_t* table, v128_t io, v128_t jo) {
+    return wasm_v128_xor(SWIZZLE(K(table, 0), io), SWIZZLE(K(table, 1), jo));
+}
+
+// middle encryption round: S-box output, round key and MixColumns
+WASM_INLINE v128_t vpaes_enc_round(v128_t x, v128_t key, uint32_t mc) {
+    v128_t io, jo, a, a2, b, d;
+    v128_t forward = K(k_mc_forward, mc);
+
+    vpaes_sbox_in(x, &io, &jo);
+
+    a = wasm_v128_xor(vpaes_sbox_out(k_sb1, io, jo), key);
+    a2 = vpaes_sbox_out(k_sb2, io, jo);
+    b = SWIZZLE(a, forward);
+    d = SWIZZLE(a, K(k_mc_backward, mc));
+
+    x = wasm_v128_xor(a2, b);                         // 2A + B
+    d = wasm_v128_xor(d, x);                          // 2A + B + D
+    return wasm_v128_xor(SWIZZLE(x, forward), d);     // 2A + 3B + C + D
+}
+
+WASM_INLINE v128_t vpaes_enc_last(v128_t x, v128_t key, uint32_t mc) {
+    v128_t io, jo;
+
+    vpaes_sbox_in(x, &io, &jo);
+
+    return SWIZZLE(wasm_v128_xor(vpaes_sbox_out(k_sbo, io, jo), key), K(k_sr, mc));
+}
+
+// middle decryption round: S-box output, round key and InvMixColumns
+WASM_INLINE v128_t vpaes_dec_round(v128_t x, v128_t key, v128_t mc) {
+    v128_t io, jo;
+
+    vpaes_sbox_in(x, &io, &jo);
+
+    x = wasm_v128_xor(key, vpaes_sbox_out(&k_dsb[0], io, jo));
+    x = wasm_v128_xor(SWIZZLE(x, mc), vpaes_sbox_out(&k_dsb[4], io, jo));
+    x = wasm_v128_xor(SWIZZLE(x, mc), vpaes_sbox_out(&k_dsb[8], io, jo));
+    return wasm_v128_xor(SWIZZLE(x, mc), vpaes_sbox_out(&k_dsb[12], io, jo));
+}
+
+v16qi aes256_encrypt(v16qi in, uint32_t* expandedKey) {
+    const v128_t* key = (const v128_t*) expandedKey;
+    v128_t x = wasm_v128_xor(vpaes_transform((v128_t) in, k_ipt), key[0]);
+    uint32_t i, mc = 1;
+
+    for (i = 1; i < VPAES_ROUNDS; ++i) {
+        x = vpaes_enc_round(x, key[i], mc);
+        mc = (mc + 1) & 3;
+    }
+
+    return (v16qi) vpaes_enc_last(x, key[VPAES_ROUNDS], mc);
+}
+
+void aes256_encrypt_x4(v16qi* blocks, uint32_t* expandedKey) {
+    const v128_t* key = (const v128_t*) expandedKey;
+    v128_t x0 = wasm_v128_xor(vpaes_transform((v128_t) blocks[0], k_ipt), key[0]);
+    v128_t x1 = wasm_v128_xor(vpaes_transform((v128_t) blocks[1], k_ipt), key[0]);
+    v128_t x2 = wasm_v128_xor(vpaes_transform((v128_t) blocks[2], k_ipt), key[0]);
+    v128_t x3 = wasm_v128_xor(vpaes_transform((v128_t) blocks[3], k_ipt), key[0]);
+    uint32_t i, mc = 1;
+
+    // the blocks are independent, so their rounds can be interleaved to hide latency
+    for (i = 1; i < VPAES_ROUNDS; ++i) {
+        x0 = vpaes_enc_round(x0, key[i], mc);
+        x1 = vpaes_enc_round(x1, key[i], mc);
+        x2 = vpaes_enc_round(x2, key[i], mc);
+        x3 = vpaes_enc_round(x3, key[i], mc);
+        mc = (mc + 1) & 3;
+    }
+
+    blocks[0] = (v16qi) vpaes_enc_last(x0, key[VPAES_ROUNDS], mc);
+    blocks[1] = (v16qi) vpaes_enc_last(x1, key[VPAES_ROUNDS], mc);
+    blocks[2] = (v16qi) vpaes_enc_last(x2, key[VPAES_ROUNDS], mc);
+    blocks[3] = (v16qi) vpaes_enc_last(x3, key[VPAES_ROUNDS], mc);
+}
+
+v16qi aes256_decrypt(v16qi in, uint32_t* expandedKey) {
+    const v128_t* key = (const v128_t*) expandedKey;
+    v128_t x = wasm_v128_xor(vpaes_transform((v128_t) in, k_dipt), key[0]);
+    v128_t mc = K(k_mc_forward, 3);
+    v128_t io, jo;
+    uint32_t i;
+
+    for (i = 1; i < VPAES_ROUNDS; ++i) {
+        x = vpaes_dec_round(x, key[i], mc);
+        mc = wasm_i8x16_shuffle(mc, mc, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11);
+    }
+
+    vpaes_sbox_in(x, &io, &jo);
+
+    return (v16qi) SWIZZLE(wasm_v128_xor(vpaes_sbox_out(&k_dsb[16], io, jo), key[VPAES_ROUNDS]), K(k_sr, 2));
+}
+
+/*
+ * Key schedule. Round keys are stored in the transformed basis, with MixColumns
+ * (or its inverse) and the ShiftRows rotation for the round already applied.
+ */
+
+// S-box of the broadcast word in `x`, added to the prefix-xor of `prev`
+WASM_INLINE v128_t vpaes_schedule_low_round(v128_t x, v128_t prev) {
+    v128_t io, jo;
+
+    prev = wasm_v128_xor(prev, wasm_i8x16_shuffle(prev, wasm_i32x4_splat(0), 16, 16, 16, 16, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11));
+    prev = wasm_v128_xor(prev, wasm_i8x16_shuffle(prev, wasm_i32x4_splat(0), 16, 16, 16, 16, 16, 16, 16, 16, 0, 1, 2, 3, 4, 5, 6, 7));
+    prev = wasm_v128_xor(prev, K(k_s63, 0));
+
+    vpaes_sbox_in(x, &io, &jo);
+
+    return wasm_v128_xor(vpaes_sbox_out(k_sb1, io, jo), prev);
+}
+
+// same as above, with RotWord and the round constant
+WASM_INLINE v128_t vpaes_schedule_round(v128_t x, v128_t prev, v128_t* rcon) {
+    prev = wasm_v128_xor(prev, wasm_i8x16_shuffle(*rcon, wasm_i32x4_splat(0), 15, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16));
+    *rcon = wasm_i8x16_shuffle(*rcon, *rcon, 15, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14);
+
+    x = wasm_i8x16_shuffle(x, x, 13, 14, 15, 12, 13, 14, 15, 12, 13, 14, 15, 12, 13, 14, 15, 12);
+
+    return vpaes_schedule_low_round(x, prev);
+}
+
+WASM_INLINE v128_t vpaes_schedule_mangle_enc(v128_t x, uint32_t sr) {
+    v128_t forward = K(k_mc_forward, 0);
+    v128_t acc;
+
+    x = SWIZZLE(wasm_v128_xor(x, K(k_s63, 0)), forward);
+    acc = x;
+    x = SWIZZLE(x, forward);
+    acc = wasm_v128_xor(acc, x);
+    x = SWIZZLE(x, forward);
+    acc = wasm_v128_xor(acc, x);
+
+    return SWIZZLE(acc, K(k_sr, sr));
+}
+
+WASM_INLINE v128_t vpaes_schedule_mangle_dec(v128_t x, uint32_t sr) {
+    v128_t forward = K(k_mc_forward, 0);
+    v128_t acc;
+
+    acc = vpaes_transform(x, &k_dks[0]);
+    acc = wasm_v128_xor(SWIZZLE(acc, forward), vpaes_transform(x, &k_dks[4]));
+    acc = wasm_v128_xor(SWIZZLE(acc, forward), vpaes_transform(x, &k_dks[8]));
+    acc = wasm_v128_xor(SWIZZLE(acc, forward), vpaes_transform(x, &k_dks[12]));
+
+    return SWIZZLE(acc, K(k_sr, sr));
+}
+
+static void vpaes_schedule(uint8_t* key, uint32_t* expandedKey, int decrypt) {
+    v128_t* out = (v128_t*) expandedKey;
+    v128_t rcon = K(k_rcon, 0);
+    v128_t raw = wasm_v128_load(key);
+    v128_t prev, x, saved;
+    uint32_t i, n, sr;
+
+    prev = vpaes_transform(raw, k_ipt);
+
+    if (decrypt) {
+        // decryption keys are stored in reverse order
+        out[VPAES_ROUNDS] = SWIZZLE(raw, K(k_sr, 2));
+        sr = 1;
+    } else {
+        out[0] = prev;
+        sr = 3;
+    }
+
+    x = vpaes_transform(wasm_v128_load(key + 16), k_ipt);
+
+    for (i = 7, n = 1; ; ) {
+        out[decrypt ? VPAES_ROUNDS - n : n] = decrypt ? vpaes_schedule_mangle_dec(x, sr) : vpaes_schedule_mangle_enc(x, sr);
+        sr = (sr - 1) & 3;
+        ++n;
+
+        saved = x;
+        x = prev = vpaes_schedule_round(x, prev, &rcon);
+        if (--i == 0) break;
+
+        out[decrypt ? VPAES_ROUNDS - n : n] = decrypt ? vpaes_schedule_mangle_dec(x, sr) : vpaes_schedule_mangle_enc(x, sr);
+        sr = (sr - 1) & 3;
+        ++n;
+
+        x = vpaes_schedule_low_round(wasm_i32x4_shuffle(x, x, 3, 3, 3, 3), saved);
+    }
+
+    // last round key is transformed out of the vpaes basis
+    x = wasm_v128_xor(decrypt ? x : SWIZZLE(x, K(k_sr, sr)), K(k_s63, 0));
+    out[decrypt ? 0 : VPAES_ROUNDS] = vpaes_transform(x, decrypt ? k_deskew : k_opt);
+}
+
+void aes256_set_encryption_key(uint8_t* key, uint32_t* expandedKey) {
+    vpaes_schedule(key, expandedKey, 0);
+}
+
+void aes256_set_decryption_key(uint8_t* key, uint32_t* expandedKey) {
+    vpaes_schedule(key, expandedKey, 1);
+}
+
+#undef K
+#undef SWIZZLE
+
+#endif // AES256_VPAES
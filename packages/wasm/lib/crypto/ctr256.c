@@ -1,5 +1,8 @@
 #include "aes256.h"
 
+// number of counter blocks encrypted per iteration of the main loop (see aes256_encrypt_x4)
+#define CTR256_BLOCKS 4
+
 struct ctr256_ctx {
     alignas(16) uint32_t expandedKey[EXPANDED_KEY_SIZE];
     alignas(16) uint8_t iv[AES_BLOCK_SIZE];
@@ -20,34 +23,86 @@ WASM_EXPORT void ctr256_free(struct ctr256_ctx* ctx) {
     __free(ctx);
 }
 
+// the counter is kept as two native-endian halves of a 128-bit big-endian integer,
+// so incrementing it is a single add with a (rarely taken) carry branch
+WASM_INLINE v16qi ctr256_block(uint64_t hi, uint64_t lo) {
+    v2di block = { be64_bswap(hi), be64_bswap(lo) };
+
+    return (v16qi)block;
+}
+
+#define CTR256_INCREMENT(hi, lo) do { if (++(lo) == 0) ++(hi); } while (0)
+
+// `out` may be equal to `in` (but must not partially overlap it): every byte of the input
+// is read before the corresponding byte of the output is written
 WASM_EXPORT void ctr256(struct ctr256_ctx* ctx, uint8_t* in, uint32_t length, uint8_t *out) {
-    alignas(16) uint8_t chunk[AES_BLOCK_SIZE];
+    alignas(16) v16qi chunk[CTR256_BLOCKS];
     uint32_t* expandedKey = ctx->expandedKey;
-    uint8_t* iv = ctx->iv;
-    uint8_t state = ctx->state;
-    uint32_t i, j, k;
+    uint32_t state = ctx->state;
+    uint64_t hi = be64_bswap(load_u64_unaligned(&ctx->iv[0]));
+    uint64_t lo = be64_bswap(load_u64_unaligned(&ctx->iv[8]));
+    uint32_t i, n;
 
-    *(v16qi*)chunk = aes256_encrypt(*(v16qi*)iv, expandedKey);
+    // head: finish the block that was partially consumed by the previous call
+    if (state != 0 && length != 0) {
+        chunk[0] = aes256_encrypt(ctr256_block(hi, lo), expandedKey);
 
-    for (i = 0; i < length; i += AES_BLOCK_SIZE) {
-        for (j = 0; j < MIN(length - i, AES_BLOCK_SIZE); ++j) {
-            out[i + j] = in[i + j] ^ chunk[state++];
+        n = MIN(length, AES_BLOCK_SIZE - state);
+        for (i = 0; i < n; ++i)
+            out[i] = in[i] ^ ((uint8_t*)chunk)[state + i];
 
-            if (state >= AES_BLOCK_SIZE)
-                state = 0;
+        in += n;
+        out += n;
+        length -= n;
+        state += n;
 
-            if (state == 0) {
-                k = AES_BLOCK_SIZE;
-                while(k--)
-                    if (++iv[k])
-                        break;
+        if (state == AES_BLOCK_SIZE) {
+            state = 0;
+            CTR256_INCREMENT(hi, lo);
+        }
+    }
 
-                *(v16qi*)chunk = aes256_encrypt(*(v16qi*)iv, expandedKey);
-            }
+    // body: encrypt several independent counter blocks at once, then xor whole v128 words
+    while (length >= CTR256_BLOCKS * AES_BLOCK_SIZE) {
+        for (i = 0; i < CTR256_BLOCKS; ++i) {
+            chunk[i] = ctr256_block(hi, lo);
+            CTR256_INCREMENT(hi, lo);
         }
+
+        aes256_encrypt_x4(chunk, expandedKey);
+
+        for (i = 0; i < CTR256_BLOCKS; ++i)
+            ((v16qi_u*)out)[i] = ((v16qi_u*)in)[i] ^ chunk[i];
+
+        in += CTR256_BLOCKS * AES_BLOCK_SIZE;
+        out += CTR256_BLOCKS * AES_BLOCK_SIZE;
+        length -= CTR256_BLOCKS * AES_BLOCK_SIZE;
+    }
+
+    while (length >= AES_BLOCK_SIZE) {
+        chunk[0] = aes256_encrypt(ctr256_block(hi, lo), expandedKey);
+        CTR256_INCREMENT(hi, lo);
+
+        *(v16qi_u*)out = *(v16qi_u*)in ^ chunk[0];
+
+        in += AES_BLOCK_SIZE;
+        out += AES_BLOCK_SIZE;
+        length -= AES_BLOCK_SIZE;
     }
 
-    __free(in);
+    // tail: keep the counter, remember how much of its keystream block was used
+    if (length != 0) {
+        chunk[0] = aes256_encrypt(ctr256_block(hi, lo), expandedKey);
 
+        for (i = 0; i < length; ++i)
+            out[i] = in[i] ^ ((uint8_t*)chunk)[i];
+
+        state = length;
+    }
+
+    store_u64_unaligned(be64_bswap(hi), &ctx->iv[0]);
+    store_u64_unaligned(be64_bswap(lo), &ctx->iv[8]);
     ctx->state = state;
 }
+
+#undef CTR256_INCREMENT
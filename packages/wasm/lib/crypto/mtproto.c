@@ -0,0 +1,214 @@
+#include "aes256.h"
+#include "hash/sha1.h"
+#include "hash/sha256.h"
+
+// MTProto 2.0 message encryption, see https://core.telegram.org/mtproto/description
+
+#define MTPROTO_AUTH_KEY_SIZE 256
+#define MTPROTO_MSG_KEY_SIZE 16
+// auth_key_id + msg_key
+#define MTPROTO_HEADER_SIZE 24
+// salt + session_id + msg_id + seq_no + length
+#define MTPROTO_INNER_HEADER_SIZE 32
+
+#define MTPROTO_ERR_LENGTH -1
+#define MTPROTO_ERR_MSG_KEY -2
+#define MTPROTO_ERR_HANDLE -3
+
+struct mtproto_auth_key {
+    uint8_t key[MTPROTO_AUTH_KEY_SIZE];
+    uint8_t id[8];
+};
+
+// registered auth keys, handles are 1-based indices into this table (0 is never a valid handle)
+static struct mtproto_auth_key** auth_keys = NULL;
+static uint32_t auth_keys_capacity = 0;
+
+static struct mtproto_auth_key* mtproto_auth_key_get(uint32_t handle) {
+    if (handle == 0 || handle > auth_keys_capacity) return NULL;
+
+    return auth_keys[handle - 1];
+}
+
+/**
+ * Register an auth key, so that it stays resident in wasm memory.
+ * The 256-byte key is read from `shared_out`.
+ *
+ * @returns  handle of the key, to be released with `mtproto_auth_key_release`,
+ *   or 0 if there's not enough memory (the registered keys are left as they were)
+ */
+WASM_EXPORT uint32_t mtproto_auth_key_register() {
+    struct mtproto_auth_key* entry;
+    struct mtproto_auth_key** table;
+    uint32_t i, capacity;
+
+    for (i = 0; i < auth_keys_capacity; ++i)
+        if (auth_keys[i] == NULL) break;
+
+    if (i == auth_keys_capacity) {
+        capacity = auth_keys_capacity ? auth_keys_capacity * 2 : 16;
+        table = (struct mtproto_auth_key**) __malloc(capacity * sizeof(*table));
+        if (table == NULL) return 0;
+
+        memcpy(table, auth_keys, auth_keys_capacity * sizeof(*table));
+        memset(table + auth_keys_capacity, 0, (capacity - auth_keys_capacity) * sizeof(*table));
+
+        __free(auth_keys);
+        auth_keys = table;
+        auth_keys_capacity = capacity;
+    }
+
+    entry = (struct mtproto_auth_key*) __malloc(sizeof(struct mtproto_auth_key));
+    if (entry == NULL) return 0;
+
+    memcpy(entry->key, shared_out, MTPROTO_AUTH_KEY_SIZE);
+
+    // auth_key_id is the lower 64 bits of sha1(auth_key)
+    sha1(entry->key, MTPROTO_AUTH_KEY_SIZE);
+    memcpy(entry->id, shared_out + SHA1_DIGEST_SIZE - 8, 8);
+
+    auth_keys[i] = entry;
+
+    return i + 1;
+}
+
+WASM_EXPORT void mtproto_auth_key_release(uint32_t handle) {
+    struct mtproto_auth_key* entry = mtproto_auth_key_get(handle);
+    if (entry == NULL) return;
+
+    memset(entry, 0, sizeof(struct mtproto_auth_key));
+    __free(entry);
+
+    auth_keys[handle - 1] = NULL;
+}
+
+// derive aes key and iv from the auth key and msg_key. `x` is 0 for client messages and 8 for server messages
+static void mtproto_kdf(const uint8_t* authKey, const uint8_t* msgKey, uint32_t x, uint8_t* key, uint8_t* iv) {
+#ifdef __wasm_simd128__
+    // both hashes are computed at once in the multi-buffer implementation
+    uint8_t inputA[MTPROTO_MSG_KEY_SIZE + 36];
+    uint8_t inputB[36 + MTPROTO_MSG_KEY_SIZE];
+    const uint8_t* inputs[2] = { inputA, inputB };
+    const uint32_t lengths[2] = { sizeof(inputA), sizeof(inputB) };
+    uint8_t digests[2 * SHA256_DIGEST_SIZE];
+    uint8_t* a = digests;
+    uint8_t* b = digests + SHA256_DIGEST_SIZE;
+
+    memcpy(inputA, msgKey, MTPROTO_MSG_KEY_SIZE);
+    memcpy(inputA + MTPROTO_MSG_KEY_SIZE, authKey + x, 36);
+    memcpy(inputB, authKey + 40 + x, 36);
+    memcpy(inputB + 36, msgKey, MTPROTO_MSG_KEY_SIZE);
+
+    sha256_x4(inputs, lengths, 2, digests);
+#else
+    struct lekkit_sha256_buff ctx;
+    uint8_t a[SHA256_DIGEST_SIZE];
+    uint8_t b[SHA256_DIGEST_SIZE];
+
+    lekkit_sha256_init(&ctx);
+    lekkit_sha256_update(&ctx, msgKey, MTPROTO_MSG_KEY_SIZE);
+    lekkit_sha256_update(&ctx, authKey + x, 36);
+    lekkit_sha256_finalize(&ctx);
+    lekkit_sha256_read(&ctx, a);
+
+    lekkit_sha256_init(&ctx);
+    lekkit_sha256_update(&ctx, authKey + 40 + x, 36);
+    lekkit_sha256_update(&ctx, msgKey, MTPROTO_MSG_KEY_SIZE);
+    lekkit_sha256_finalize(&ctx);
+    lekkit_sha256_read(&ctx, b);
+#endif
+
+    memcpy(key, a, 8);
+    memcpy(key + 8, b + 8, 16);
+    memcpy(key + 24, a + 24, 8);
+
+    memcpy(iv, b, 8);
+    memcpy(iv + 8, a + 8, 16);
+    memcpy(iv + 24, b + 24, 8);
+}
+
+/**
+ * Encrypt a client message in place.
+ *
+ * `buf` must contain 24 bytes of space for auth_key_id and msg_key, followed by
+ * `length` bytes of plaintext (salt, session id, message and random padding,
+ * a multiple of 16 bytes in total).
+ *
+ * On return, `buf` contains `auth_key_id || msg_key || encrypted_data`.
+ *
+ * @returns  0 on success, or a negative error code (MTPROTO_ERR_*)
+ */
+WASM_EXPORT int32_t mtproto_encrypt_message(uint32_t handle, uint8_t* buf, uint32_t length) {
+    struct mtproto_auth_key* entry = mtproto_auth_key_get(handle);
+    struct lekkit_sha256_buff ctx;
+    uint8_t msgKeyLarge[SHA256_DIGEST_SIZE];
+    uint8_t key[32];
+    uint8_t iv[32];
+    uint8_t* msgKey = buf + 8;
+    uint8_t* data = buf + MTPROTO_HEADER_SIZE;
+    uint8_t* authKey;
+
+    if (entry == NULL) return MTPROTO_ERR_HANDLE;
+    authKey = entry->key;
+
+    memcpy(buf, entry->id, 8);
+
+    lekkit_sha256_init(&ctx);
+    lekkit_sha256_update(&ctx, authKey + 88, 32);
+    lekkit_sha256_update(&ctx, data, length);
+    lekkit_sha256_finalize(&ctx);
+    lekkit_sha256_read(&ctx, msgKeyLarge);
+
+    memcpy(msgKey, msgKeyLarge + 8, MTPROTO_MSG_KEY_SIZE);
+
+    mtproto_kdf(authKey, msgKey, 0, key, iv);
+    aes256_ige_encrypt(data, length, data, key, iv);
+
+    return 0;
+}
+
+/**
+ * Decrypt a server message in place and verify its msg_key.
+ *
+ * `buf` must contain `auth_key_id || msg_key || encrypted_data`, `length` bytes in total.
+ * Trailing bytes of a padded transport (not a multiple of 16) are ignored.
+ *
+ * @returns  length of the verified plaintext, which starts at `buf + 24`,
+ *   or a negative error code (MTPROTO_ERR_*)
+ */
+WASM_EXPORT int32_t mtproto_decrypt_message(uint32_t handle, uint8_t* buf, uint32_t length) {
+    struct mtproto_auth_key* entry = mtproto_auth_key_get(handle);
+    struct lekkit_sha256_buff ctx;
+    uint8_t msgKeyLarge[SHA256_DIGEST_SIZE];
+    uint8_t key[32];
+    uint8_t iv[32];
+    uint8_t* msgKey = buf + 8;
+    uint8_t* data = buf + MTPROTO_HEADER_SIZE;
+    uint8_t* authKey;
+    uint8_t diff = 0;
+    uint32_t i;
+
+    if (entry == NULL) return MTPROTO_ERR_HANDLE;
+    if (length < MTPROTO_HEADER_SIZE + MTPROTO_INNER_HEADER_SIZE) return MTPROTO_ERR_LENGTH;
+
+    authKey = entry->key;
+
+    length = (length - MTPROTO_HEADER_SIZE) & ~(AES_BLOCK_SIZE - 1);
+
+    mtproto_kdf(authKey, msgKey, 8, key, iv);
+    aes256_ige_decrypt(data, length, data, key, iv);
+
+    lekkit_sha256_init(&ctx);
+    lekkit_sha256_update(&ctx, authKey + 96, 32);
+    lekkit_sha256_update(&ctx, data, length);
+    lekkit_sha256_finalize(&ctx);
+    lekkit_sha256_read(&ctx, msgKeyLarge);
+
+    // constant-time compare
+    for (i = 0; i < MTPROTO_MSG_KEY_SIZE; ++i)
+        diff |= msgKey[i] ^ msgKeyLarge[8 + i];
+
+    if (diff != 0) return MTPROTO_ERR_MSG_KEY;
+
+    return (int32_t) length;
+}
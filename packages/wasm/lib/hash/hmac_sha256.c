@@ -0,0 +1,66 @@
+#include "sha256.h"
+
+/*
+ * HMAC-SHA256 with a reusable key. The states after absorbing the ipad and opad blocks
+ * are computed once, so every message costs only the hashing of the message itself
+ * and two finalizations.
+ */
+
+#define HMAC_BLOCK_SIZE 64
+
+struct hmac_sha256_ctx {
+    struct lekkit_sha256_buff inner;
+    struct lekkit_sha256_buff outer;
+};
+
+WASM_EXPORT struct hmac_sha256_ctx* hmac_sha256_alloc(const uint8_t* key, uint32_t keyLen) {
+    struct hmac_sha256_ctx* ctx = (struct hmac_sha256_ctx*) __malloc(sizeof(struct hmac_sha256_ctx));
+    uint8_t block[HMAC_BLOCK_SIZE];
+    uint32_t i;
+
+    memset(block, 0, HMAC_BLOCK_SIZE);
+
+    // keys longer than the block size are hashed first
+    if (keyLen > HMAC_BLOCK_SIZE) {
+        lekkit_sha256_init(&ctx->inner);
+        lekkit_sha256_update(&ctx->inner, key, keyLen);
+        lekkit_sha256_finalize(&ctx->inner);
+        lekkit_sha256_read(&ctx->inner, block);
+    } else {
+        memcpy(block, key, keyLen);
+    }
+
+    for (i = 0; i < HMAC_BLOCK_SIZE; ++i) block[i] ^= 0x36;
+    lekkit_sha256_init(&ctx->inner);
+    lekkit_sha256_update(&ctx->inner, block, HMAC_BLOCK_SIZE);
+
+    // 0x36 ^ 0x5c
+    for (i = 0; i < HMAC_BLOCK_SIZE; ++i) block[i] ^= 0x6a;
+    lekkit_sha256_init(&ctx->outer);
+    lekkit_sha256_update(&ctx->outer, block, HMAC_BLOCK_SIZE);
+
+    memset(block, 0, HMAC_BLOCK_SIZE);
+
+    return ctx;
+}
+
+WASM_EXPORT void hmac_sha256_free(struct hmac_sha256_ctx* ctx) {
+    // the precomputed states are as good as the key itself
+    memset(ctx, 0, sizeof(struct hmac_sha256_ctx));
+    __free(ctx);
+}
+
+WASM_EXPORT void hmac_sha256(const struct hmac_sha256_ctx* ctx, const uint8_t* data, uint32_t size, uint8_t* out) {
+    struct lekkit_sha256_buff state;
+    uint8_t digest[SHA256_DIGEST_SIZE];
+
+    memcpy(&state, &ctx->inner, sizeof(struct lekkit_sha256_buff));
+    lekkit_sha256_update(&state, data, size);
+    lekkit_sha256_finalize(&state);
+    lekkit_sha256_read(&state, digest);
+
+    memcpy(&state, &ctx->outer, sizeof(struct lekkit_sha256_buff));
+    lekkit_sha256_update(&state, digest, SHA256_DIGEST_SIZE);
+    lekkit_sha256_finalize(&state);
+    lekkit_sha256_read(&state, out);
+}
@@ -0,0 +1,119 @@
+#include "sha512.h"
+
+/*
+ * PBKDF2-HMAC-SHA512.
+ *
+ * The HMAC states after absorbing the ipad/opad blocks are computed once. Every
+ * iteration after the first one hashes exactly one 64-byte digest, so its padded
+ * block is built directly from the state words of the previous step, and each
+ * iteration is just two compressions, without any byte (de)serialization.
+ */
+
+// a 64-byte message after a full key block: 0x80 padding and a length of 192 bytes
+#define FILL_PADDING(w) do { \
+    (w)[8] = 0x8000000000000000; \
+    (w)[9] = (w)[10] = (w)[11] = (w)[12] = (w)[13] = (w)[14] = 0; \
+    (w)[15] = (SHA512_BLOCK_SIZE + SHA512_DIGEST_SIZE) * 8; \
+} while (0)
+
+static void hmac_sha512_key(const uint8_t* key, uint32_t keyLen, uint64_t* inner, uint64_t* outer) {
+    struct sha512_ctx ctx;
+    uint8_t block[SHA512_BLOCK_SIZE];
+    uint32_t i;
+
+    memset(block, 0, SHA512_BLOCK_SIZE);
+
+    // keys longer than the block size are hashed first
+    if (keyLen > SHA512_BLOCK_SIZE) {
+        sha512_init(&ctx);
+        sha512_update(&ctx, key, keyLen);
+        sha512_final(&ctx, block);
+    } else {
+        memcpy(block, key, keyLen);
+    }
+
+    for (i = 0; i < SHA512_BLOCK_SIZE; ++i) block[i] ^= 0x36;
+    sha512_init(&ctx);
+    sha512_update(&ctx, block, SHA512_BLOCK_SIZE);
+    memcpy(inner, ctx.h, sizeof(ctx.h));
+
+    // 0x36 ^ 0x5c
+    for (i = 0; i < SHA512_BLOCK_SIZE; ++i) block[i] ^= 0x6a;
+    sha512_init(&ctx);
+    sha512_update(&ctx, block, SHA512_BLOCK_SIZE);
+    memcpy(outer, ctx.h, sizeof(ctx.h));
+
+    memset(block, 0, SHA512_BLOCK_SIZE);
+    memset(&ctx, 0, sizeof(ctx));
+}
+
+// derive `outLen` bytes from `password` and `salt`
+WASM_EXPORT void pbkdf2_sha512(
+    const uint8_t* password,
+    uint32_t passwordLen,
+    const uint8_t* salt,
+    uint32_t saltLen,
+    uint32_t iterations,
+    uint8_t* out,
+    uint32_t outLen
+) {
+    struct sha512_ctx ctx;
+    uint64_t inner[8], outer[8];
+    uint64_t w[16], t[8], u[8];
+    uint8_t digest[SHA512_DIGEST_SIZE];
+    uint8_t counter[4];
+    uint32_t block, i, j, n;
+
+    hmac_sha512_key(password, passwordLen, inner, outer);
+
+    for (block = 1; outLen != 0; ++block) {
+        // U_1 = HMAC(password, salt || INT(block))
+        memcpy(ctx.h, inner, sizeof(inner));
+        ctx.data_size = SHA512_BLOCK_SIZE;
+        ctx.buffer_size = 0;
+
+        put_unaligned_be32(block, counter);
+        sha512_update(&ctx, salt, saltLen);
+        sha512_update(&ctx, counter, 4);
+        sha512_final(&ctx, digest);
+
+        for (i = 0; i < 8; i++) {
+            w[i] = be64_bswap(load_u64_unaligned(digest + i * 8));
+        }
+        FILL_PADDING(w);
+
+        memcpy(t, outer, sizeof(outer));
+        sha512_compress(t, w);
+        memcpy(w, t, sizeof(t));
+
+        // U_j = HMAC(password, U_{j-1}), t = U_1 ^ ... ^ U_j.
+        // the padding in w[8..15] is the same for both hashes, and is never overwritten
+        for (j = 1; j < iterations; j++) {
+            memcpy(u, inner, sizeof(inner));
+            sha512_compress(u, w);
+            memcpy(w, u, sizeof(u));
+
+            memcpy(u, outer, sizeof(outer));
+            sha512_compress(u, w);
+            memcpy(w, u, sizeof(u));
+
+            for (i = 0; i < 8; i++) t[i] ^= u[i];
+        }
+
+        n = MIN(outLen, SHA512_DIGEST_SIZE);
+        for (i = 0; i < n; i++) {
+            out[i] = (uint8_t) (t[i / 8] >> (56 - (i % 8) * 8));
+        }
+
+        out += n;
+        outLen -= n;
+    }
+
+    memset(inner, 0, sizeof(inner));
+    memset(outer, 0, sizeof(outer));
+    memset(w, 0, sizeof(w));
+    memset(t, 0, sizeof(t));
+    memset(u, 0, sizeof(u));
+}
+
+#undef FILL_PADDING
@@ -1,179 +1,280 @@
-/*******************************************************************************
- * Teeny SHA-1
- *
- * The below sha1digest() calculates a SHA-1 hash value for a
- * specified data buffer and generates a hex representation of the
- * result.  This implementation is a re-forming of the SHA-1 code at
- * https://github.com/jinqiangshou/EncryptionLibrary.
- *
- * Copyright (c) 2017 CTrabant
- *
- * License: MIT, see included LICENSE file for details.
+#include "sha1.h"
+#include <stdalign.h>
+
+/*
+ * SHA-1 with a streaming context.
  *
- * To use the sha1digest() function either copy it into an existing
- * project source code file or include this file in a project and put
- * the declaration (example below) in the sources files where needed.
- ******************************************************************************/
+ * The 80 rounds are fully unrolled, with the working variables rotated through
+ * the macro arguments instead of being shifted on every round. The message schedule
+ * is computed on the fly in a rolling window of 16 words, or (in the SIMD build)
+ * precomputed 4 words at a time, together with the round constants.
+ */
 
-#include "wasm.h"
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
 
-/* Declaration:
-extern int sha1digest(uint8_t *digest, char *hexdigest, const uint8_t *data, size_t databytes);
-*/
+#define SHA1_K0 0x5a827999
+#define SHA1_K1 0x6ed9eba1
+#define SHA1_K2 0x8f1bbcdc
+#define SHA1_K3 0xca62c1d6
 
-/*******************************************************************************
- * sha1digest: https://github.com/CTrabant/teeny-sha1
- *
- * Calculate the SHA-1 value for supplied data buffer and generate a
- * text representation in hexadecimal.
- *
- * Based on https://github.com/jinqiangshou/EncryptionLibrary, credit
- * goes to @jinqiangshou, all new bugs are mine.
- *
- * @input:
- *    data      -- data to be hashed
- *    databytes -- bytes in data buffer to be hashed
- *
- * @output:
- *    digest    -- the result, MUST be at least 20 bytes
- *    hexdigest -- the result in hex, MUST be at least 41 bytes
- *
- * At least one of the output buffers must be supplied.  The other, if not 
- * desired, may be set to NULL.
- *
- * @return: 0 on success and non-zero on error.
- ******************************************************************************/
-WASM_EXPORT void sha1(const uint8_t *data, size_t databytes) {
-#define SHA1ROTATELEFT(value, bits) (((value) << (bits)) | ((value) >> (32 - (bits))))
-
-  uint32_t W[80];
-  uint32_t H[] = {0x67452301,
-                  0xEFCDAB89,
-                  0x98BADCFE,
-                  0x10325476,
-                  0xC3D2E1F0};
-  uint32_t a;
-  uint32_t b;
-  uint32_t c;
-  uint32_t d;
-  uint32_t e;
-  uint32_t f = 0;
-  uint32_t k = 0;
-
-  uint32_t idx;
-  uint32_t lidx;
-  uint32_t widx;
-  uint32_t didx = 0;
-
-  int32_t wcount;
-  uint32_t temp;
-  uint64_t databits = ((uint64_t)databytes) * 8;
-  uint32_t loopcount = (databytes + 8) / 64 + 1;
-  uint32_t tailbytes = 64 * loopcount - databytes;
-  uint8_t datatail[128] = {0};
-
-  /* Pre-processing of data tail (includes padding to fill out 512-bit chunk):
-     Add bit '1' to end of message (big-endian)
-     Add 64-bit message length in bits at very end (big-endian) */
-  datatail[0] = 0x80;
-  datatail[tailbytes - 8] = (uint8_t) (databits >> 56 & 0xFF);
-  datatail[tailbytes - 7] = (uint8_t) (databits >> 48 & 0xFF);
-  datatail[tailbytes - 6] = (uint8_t) (databits >> 40 & 0xFF);
-  datatail[tailbytes - 5] = (uint8_t) (databits >> 32 & 0xFF);
-  datatail[tailbytes - 4] = (uint8_t) (databits >> 24 & 0xFF);
-  datatail[tailbytes - 3] = (uint8_t) (databits >> 16 & 0xFF);
-  datatail[tailbytes - 2] = (uint8_t) (databits >> 8 & 0xFF);
-  datatail[tailbytes - 1] = (uint8_t) (databits >> 0 & 0xFF);
-
-  /* Process each 512-bit chunk */
-  for (lidx = 0; lidx < loopcount; lidx++)
-  {
-    /* Compute all elements in W */
-    memset (W, 0, 80 * sizeof (uint32_t));
-
-    /* Break 512-bit chunk into sixteen 32-bit, big endian words */
-    for (widx = 0; widx <= 15; widx++)
-    {
-      wcount = 24;
-
-      /* Copy byte-per byte from specified buffer */
-      while (didx < databytes && wcount >= 0)
-      {
-        W[widx] += (((uint32_t)data[didx]) << wcount);
-        didx++;
-        wcount -= 8;
-      }
-      /* Fill out W with padding as needed */
-      while (wcount >= 0)
-      {
-        W[widx] += (((uint32_t)datatail[didx - databytes]) << wcount);
-        didx++;
-        wcount -= 8;
-      }
+#define ROL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define F0(b, c, d) ((d) ^ ((b) & ((c) ^ (d))))
+#define F1(b, c, d) ((b) ^ (c) ^ (d))
+#define F2(b, c, d) (((b) & (c)) | ((d) & ((b) | (c))))
+#define F3(b, c, d) F1(b, c, d)
+
+#define ROUND(f, a, b, c, d, e, wk) do { \
+    e += ROL(a, 5) + f(b, c, d) + (wk); \
+    b = ROL(b, 30); \
+} while (0)
+
+// five rounds bring the working variables back to their original order
+#define ROUND5(f, k, i) \
+    ROUND(f, a, b, c, d, e, WK(k, i)); \
+    ROUND(f, e, a, b, c, d, WK(k, i + 1)); \
+    ROUND(f, d, e, a, b, c, WK(k, i + 2)); \
+    ROUND(f, c, d, e, a, b, WK(k, i + 3)); \
+    ROUND(f, b, c, d, e, a, WK(k, i + 4));
+
+#define ROUNDS \
+    ROUND5(F0, SHA1_K0, 0) ROUND5(F0, SHA1_K0, 5) ROUND5(F0, SHA1_K0, 10) ROUND5(F0, SHA1_K0, 15) \
+    ROUND5(F1, SHA1_K1, 20) ROUND5(F1, SHA1_K1, 25) ROUND5(F1, SHA1_K1, 30) ROUND5(F1, SHA1_K1, 35) \
+    ROUND5(F2, SHA1_K2, 40) ROUND5(F2, SHA1_K2, 45) ROUND5(F2, SHA1_K2, 50) ROUND5(F2, SHA1_K2, 55) \
+    ROUND5(F3, SHA1_K3, 60) ROUND5(F3, SHA1_K3, 65) ROUND5(F3, SHA1_K3, 70) ROUND5(F3, SHA1_K3, 75)
+
+WASM_INLINE uint32_t sha1_load_be32(const uint8_t* p) {
+    uint32_t v;
+    __builtin_memcpy(&v, p, 4);
+
+    return __builtin_bswap32(v);
+}
+
+#ifdef __wasm_simd128__
+
+// w[i..i+3] = rol1(w[i-3..i] ^ w[i-8..i-5] ^ w[i-14..i-11] ^ w[i-16..i-13]).
+// w[i] is not known yet when computing w[i+3], so the last lane is computed with 0 instead,
+// and fixed up afterwards (rotation distributes over xor)
+static void sha1_schedule(const uint8_t* block, uint32_t* wk) {
+    const v128_t zero = wasm_i32x4_splat(0);
+    v128_t w0, w1, w2, w3, t;
+    v128_t k = wasm_i32x4_splat(SHA1_K0);
+    uint32_t i;
+
+#define LOAD_BE(p) wasm_i8x16_shuffle(wasm_v128_load(p), zero, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)
+#define ROL_V(x, n) wasm_v128_or(wasm_i32x4_shl(x, n), wasm_u32x4_shr(x, 32 - n))
+
+    w0 = LOAD_BE(block);
+    w1 = LOAD_BE(block + 16);
+    w2 = LOAD_BE(block + 32);
+    w3 = LOAD_BE(block + 48);
+
+    wasm_v128_store(&wk[0], wasm_i32x4_add(w0, k));
+    wasm_v128_store(&wk[4], wasm_i32x4_add(w1, k));
+    wasm_v128_store(&wk[8], wasm_i32x4_add(w2, k));
+    wasm_v128_store(&wk[12], wasm_i32x4_add(w3, k));
+
+    for (i = 16; i < 80; i += 4) {
+        if (i == 20) k = wasm_i32x4_splat(SHA1_K1);
+        else if (i == 40) k = wasm_i32x4_splat(SHA1_K2);
+        else if (i == 60) k = wasm_i32x4_splat(SHA1_K3);
+
+        t = wasm_v128_xor(
+            wasm_v128_xor(wasm_i32x4_shuffle(w3, zero, 1, 2, 3, 4), w2),
+            wasm_v128_xor(wasm_i32x4_shuffle(w0, w1, 2, 3, 4, 5), w0)
+        );
+        t = ROL_V(t, 1);
+        t = wasm_v128_xor(t, ROL_V(wasm_i32x4_shuffle(zero, t, 0, 1, 2, 4), 1));
+
+        wasm_v128_store(&wk[i], wasm_i32x4_add(t, k));
+
+        w0 = w1;
+        w1 = w2;
+        w2 = w3;
+        w3 = t;
     }
 
-    /* Extend the sixteen 32-bit words into eighty 32-bit words, with potential optimization from:
-       "Improving the Performance of the Secure Hash Algorithm (SHA-1)" by Max Locktyukhin */
-    for (widx = 16; widx <= 31; widx++)
-    {
-      W[widx] = SHA1ROTATELEFT ((W[widx - 3] ^ W[widx - 8] ^ W[widx - 14] ^ W[widx - 16]), 1);
+#undef LOAD_BE
+#undef ROL_V
+}
+
+#define WK(k, i) wk[i]
+
+static void sha1_blocks(uint32_t* h, const uint8_t* data, uint32_t blocks) {
+    alignas(16) uint32_t wk[80];
+    uint32_t a, b, c, d, e;
+
+    for (; blocks != 0; --blocks, data += SHA1_BLOCK_SIZE) {
+        sha1_schedule(data, wk);
+
+        a = h[0];
+        b = h[1];
+        c = h[2];
+        d = h[3];
+        e = h[4];
+
+        ROUNDS
+
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
     }
-    for (widx = 32; widx <= 79; widx++)
-    {
-      W[widx] = SHA1ROTATELEFT ((W[widx - 6] ^ W[widx - 16] ^ W[widx - 28] ^ W[widx - 32]), 2);
+}
+
+#else
+
+#define W(i) w[(i) & 15]
+#define WK(k, i) ((i) < 16 \
+    ? (W(i) = sha1_load_be32(data + 4 * (i))) + (k) \
+    : (W(i) = ROL(W((i) + 13) ^ W((i) + 8) ^ W((i) + 2) ^ W(i), 1)) + (k))
+
+static void sha1_blocks(uint32_t* h, const uint8_t* data, uint32_t blocks) {
+    uint32_t w[16];
+    uint32_t a, b, c, d, e;
+
+    for (; blocks != 0; --blocks, data += SHA1_BLOCK_SIZE) {
+        a = h[0];
+        b = h[1];
+        c = h[2];
+        d = h[3];
+        e = h[4];
+
+        ROUNDS
+
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+}
+
+#undef W
+
+#endif
+
+void sha1_init(struct sha1_ctx* ctx) {
+    ctx->h[0] = 0x67452301;
+    ctx->h[1] = 0xefcdab89;
+    ctx->h[2] = 0x98badcfe;
+    ctx->h[3] = 0x10325476;
+    ctx->h[4] = 0xc3d2e1f0;
+    ctx->buffer_size = 0;
+    ctx->data_size = 0;
+}
+
+WASM_EXPORT void sha1_update(struct sha1_ctx* ctx, const uint8_t* data, uint32_t size) {
+    uint32_t n;
+
+    ctx->data_size += size;
+
+    // complete the block buffered by the previous call
+    if (ctx->buffer_size != 0) {
+        n = MIN(size, SHA1_BLOCK_SIZE - ctx->buffer_size);
+        memcpy(ctx->buffer + ctx->buffer_size, data, n);
+        ctx->buffer_size += n;
+        data += n;
+        size -= n;
+
+        if (ctx->buffer_size < SHA1_BLOCK_SIZE) return;
+
+        sha1_blocks(ctx->h, ctx->buffer, 1);
+        ctx->buffer_size = 0;
     }
 
-    /* Main loop */
-    a = H[0];
-    b = H[1];
-    c = H[2];
-    d = H[3];
-    e = H[4];
-
-    for (idx = 0; idx <= 79; idx++)
-    {
-      if (idx <= 19)
-      {
-        f = (b & c) | ((~b) & d);
-        k = 0x5A827999;
-      }
-      else if (idx >= 20 && idx <= 39)
-      {
-        f = b ^ c ^ d;
-        k = 0x6ED9EBA1;
-      }
-      else if (idx >= 40 && idx <= 59)
-      {
-        f = (b & c) | (b & d) | (c & d);
-        k = 0x8F1BBCDC;
-      }
-      else if (idx >= 60 && idx <= 79)
-      {
-        f = b ^ c ^ d;
-        k = 0xCA62C1D6;
-      }
-      temp = SHA1ROTATELEFT (a, 5) + f + e + k + W[idx];
-      e = d;
-      d = c;
-      c = SHA1ROTATELEFT (b, 30);
-      b = a;
-      a = temp;
+    if (size >= SHA1_BLOCK_SIZE) {
+        sha1_blocks(ctx->h, data, size / SHA1_BLOCK_SIZE);
+        data += size & ~(SHA1_BLOCK_SIZE - 1);
+        size &= SHA1_BLOCK_SIZE - 1;
     }
 
-    H[0] += a;
-    H[1] += b;
-    H[2] += c;
-    H[3] += d;
-    H[4] += e;
-  }
-
-  /* Store binary digest in supplied buffer */
-  for (idx = 0; idx < 5; idx++) {
-    shared_out[idx * 4 + 0] = (uint8_t) (H[idx] >> 24);
-    shared_out[idx * 4 + 1] = (uint8_t) (H[idx] >> 16);
-    shared_out[idx * 4 + 2] = (uint8_t) (H[idx] >> 8);
-    shared_out[idx * 4 + 3] = (uint8_t) (H[idx]);
-  }
-
-  #undef SHA1ROTATELEFT
-}  /* End of sha1digest() */
\ No newline at end of file
+    memcpy(ctx->buffer, data, size);
+    ctx->buffer_size = size;
+}
+
+WASM_EXPORT void sha1_final(struct sha1_ctx* ctx, uint8_t* out) {
+    uint32_t n = ctx->buffer_size;
+    uint64_t bits = ctx->data_size * 8;
+    uint32_t i;
+
+    ctx->buffer[n++] = 0x80;
+
+    // not enough space for the length, it goes to the next block
+    if (n > SHA1_BLOCK_SIZE - 8) {
+        memset(ctx->buffer + n, 0, SHA1_BLOCK_SIZE - n);
+        sha1_blocks(ctx->h, ctx->buffer, 1);
+        n = 0;
+    }
+
+    memset(ctx->buffer + n, 0, SHA1_BLOCK_SIZE - 8 - n);
+    put_unaligned_be32((uint32_t) (bits >> 32), ctx->buffer + 56);
+    put_unaligned_be32((uint32_t) bits, ctx->buffer + 60);
+    sha1_blocks(ctx->h, ctx->buffer, 1);
+
+    for (i = 0; i < 5; i++) {
+        put_unaligned_be32(ctx->h[i], out + i * 4);
+    }
+
+    sha1_init(ctx);
+}
+
+WASM_EXPORT void sha1(const uint8_t *data, size_t databytes) {
+    struct sha1_ctx ctx;
+
+    sha1_init(&ctx);
+    sha1_update(&ctx, data, databytes);
+    sha1_final(&ctx, shared_out);
+}
+
+// hash the concatenation of `count` slices, described by `iov` as (pointer, length) pairs
+WASM_EXPORT void sha1_iov(const uint32_t* iov, uint32_t count, uint8_t* out) {
+    struct sha1_ctx ctx;
+
+    sha1_init(&ctx);
+
+    for (; count != 0; --count, iov += 2) {
+        sha1_update(&ctx, (const uint8_t*) (size_t) iov[0], iov[1]);
+    }
+
+    sha1_final(&ctx, out);
+}
+
+/*
+ * Streaming API, same as for SHA-256 (see sha256.c)
+ */
+
+WASM_EXPORT struct sha1_ctx* sha1_alloc() {
+    struct sha1_ctx* ctx = (struct sha1_ctx*) __malloc(sizeof(struct sha1_ctx));
+    sha1_init(ctx);
+
+    return ctx;
+}
+
+WASM_EXPORT struct sha1_ctx* sha1_clone(const struct sha1_ctx* ctx) {
+    struct sha1_ctx* copy = (struct sha1_ctx*) __malloc(sizeof(struct sha1_ctx));
+    memcpy(copy, ctx, sizeof(struct sha1_ctx));
+
+    return copy;
+}
+
+WASM_EXPORT void sha1_free(struct sha1_ctx* ctx) {
+    __free(ctx);
+}
+
+WASM_EXPORT void sha1_reset(struct sha1_ctx* ctx) {
+    sha1_init(ctx);
+}
+
+#undef ROL
+#undef F0
+#undef F1
+#undef F2
+#undef F3
+#undef ROUND
+#undef ROUND5
+#undef ROUNDS
+#undef WK
@@ -0,0 +1,24 @@
+#include "wasm.h"
+
+#ifndef SHA1_H
+#define SHA1_H
+
+#define SHA1_DIGEST_SIZE 20
+#define SHA1_BLOCK_SIZE 64
+
+struct sha1_ctx {
+    uint32_t h[5];
+    uint32_t buffer_size;
+    uint64_t data_size;
+    uint8_t buffer[SHA1_BLOCK_SIZE];
+};
+
+void sha1_init(struct sha1_ctx* ctx);
+void sha1_update(struct sha1_ctx* ctx, const uint8_t* data, uint32_t size);
+// writes the digest to `out` and re-initializes the context
+void sha1_final(struct sha1_ctx* ctx, uint8_t* out);
+
+// one-shot SHA-1, the digest is written to `shared_out`
+void sha1(const uint8_t *data, size_t databytes);
+
+#endif // SHA1_H
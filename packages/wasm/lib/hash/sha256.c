@@ -22,14 +22,12 @@
     SOFTWARE.
 */
 
-#include "wasm.h"
+#include "sha256.h"
+#include <stdalign.h>
 
-struct lekkit_sha256_buff {
-    uint64_t data_size;
-    uint32_t h[8];
-    uint8_t last_chunk[64];
-    uint8_t chunk_size;
-};
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
 
 void lekkit_sha256_init(struct lekkit_sha256_buff* buff) {
     buff->h[0] = 0x6a09e667;
@@ -44,7 +42,7 @@ void lekkit_sha256_init(struct lekkit_sha256_buff* buff) {
     buff->chunk_size = 0;
 }
 
-static const uint32_t lekkit_k[64] = {
+static const alignas(16) uint32_t lekkit_k[64] = {
     0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
     0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
     0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
@@ -57,11 +55,66 @@ static const uint32_t lekkit_k[64] = {
 
 #define rotate_r(val, bits) (val >> bits | val << (32 - bits))
 
+#ifdef __wasm_simd128__
+
+#define rotate_r_v(val, bits) wasm_v128_or(wasm_u32x4_shr(val, bits), wasm_i32x4_shl(val, 32 - bits))
+#define sigma0_v(x) wasm_v128_xor(wasm_v128_xor(rotate_r_v(x, 7), rotate_r_v(x, 18)), wasm_u32x4_shr(x, 3))
+#define sigma1_v(x) wasm_v128_xor(wasm_v128_xor(rotate_r_v(x, 17), rotate_r_v(x, 19)), wasm_u32x4_shr(x, 10))
+#define load_be_v(p) wasm_i8x16_shuffle(wasm_v128_load(p), wasm_v128_load(p), \
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)
+
+/*
+ * Computes w[i] + k[i] for all 64 rounds, 4 words at a time.
+ * w[i+2] and w[i+3] depend on w[i] and w[i+1] through sigma1, so sigma1 is applied
+ * in two halves: first for the lower lanes (with the previous words), then for the upper ones
+ */
+static void lekkit_sha256_schedule(const uint8_t* chunk, uint32_t* wk) {
+    const v128_t zero = wasm_i32x4_splat(0);
+    v128_t w0 = load_be_v(chunk);
+    v128_t w1 = load_be_v(chunk + 16);
+    v128_t w2 = load_be_v(chunk + 32);
+    v128_t w3 = load_be_v(chunk + 48);
+    v128_t t;
+    uint32_t i;
+
+    wasm_v128_store(&wk[0], wasm_i32x4_add(w0, wasm_v128_load(&lekkit_k[0])));
+    wasm_v128_store(&wk[4], wasm_i32x4_add(w1, wasm_v128_load(&lekkit_k[4])));
+    wasm_v128_store(&wk[8], wasm_i32x4_add(w2, wasm_v128_load(&lekkit_k[8])));
+    wasm_v128_store(&wk[12], wasm_i32x4_add(w3, wasm_v128_load(&lekkit_k[12])));
+
+    for (i = 16; i < 64; i += 4) {
+        // w[i-16] + sigma0(w[i-15]) + w[i-7]
+        t = wasm_i32x4_add(
+            wasm_i32x4_add(w0, sigma0_v(wasm_i32x4_shuffle(w0, w1, 1, 2, 3, 4))),
+            wasm_i32x4_shuffle(w2, w3, 1, 2, 3, 4)
+        );
+        // + sigma1(w[i-2]), lanes 0 and 1
+        t = wasm_i32x4_add(t, sigma1_v(wasm_i32x4_shuffle(w3, zero, 2, 3, 4, 4)));
+        // + sigma1(w[i]), lanes 2 and 3
+        t = wasm_i32x4_add(t, sigma1_v(wasm_i32x4_shuffle(zero, t, 0, 0, 4, 5)));
+
+        wasm_v128_store(&wk[i], wasm_i32x4_add(t, wasm_v128_load(&lekkit_k[i])));
+
+        w0 = w1;
+        w1 = w2;
+        w2 = w3;
+        w3 = t;
+    }
+}
+
+#endif
+
 static void lekkit_sha256_calc_chunk(struct lekkit_sha256_buff* buff, const uint8_t* chunk) {
-    uint32_t w[64];
     uint32_t tv[8];
     uint32_t i;
 
+#ifdef __wasm_simd128__
+    alignas(16) uint32_t wk[64];
+
+    lekkit_sha256_schedule(chunk, wk);
+#else
+    uint32_t w[64];
+
     for (i=0; i<16; ++i){
         w[i] = (uint32_t) chunk[0] << 24 | (uint32_t) chunk[1] << 16 | (uint32_t) chunk[2] << 8 | (uint32_t) chunk[3];
         chunk += 4;
@@ -72,6 +125,7 @@ static void lekkit_sha256_calc_chunk(struct lekkit_sha256_buff* buff, const uint
         uint32_t s1 = rotate_r(w[i-2], 17) ^ rotate_r(w[i-2], 19) ^ (w[i-2] >> 10);
         w[i] = w[i-16] + s0 + w[i-7] + s1;
     }
+#endif
     
     for (i = 0; i < 8; ++i)
         tv[i] = buff->h[i];
@@ -79,7 +133,11 @@ static void lekkit_sha256_calc_chunk(struct lekkit_sha256_buff* buff, const uint
     for (i=0; i<64; ++i){
         uint32_t S1 = rotate_r(tv[4], 6) ^ rotate_r(tv[4], 11) ^ rotate_r(tv[4], 25);
         uint32_t ch = (tv[4] & tv[5]) ^ (~tv[4] & tv[6]);
+#ifdef __wasm_simd128__
+        uint32_t temp1 = tv[7] + S1 + ch + wk[i];
+#else
         uint32_t temp1 = tv[7] + S1 + ch + lekkit_k[i] + w[i];
+#endif
         uint32_t S0 = rotate_r(tv[0], 2) ^ rotate_r(tv[0], 13) ^ rotate_r(tv[0], 22);
         uint32_t maj = (tv[0] & tv[1]) ^ (tv[0] & tv[2]) ^ (tv[1] & tv[2]);
         uint32_t temp2 = S0 + maj;
@@ -164,4 +222,245 @@ WASM_EXPORT void sha256(const void* data, uint32_t size) {
     lekkit_sha256_read(&lekkit_shared_ctx, shared_out);
 }
 
-#undef rotate_r
\ No newline at end of file
+#ifdef __wasm_simd128__
+
+#define big_sigma0_v(x) wasm_v128_xor(wasm_v128_xor(rotate_r_v(x, 2), rotate_r_v(x, 13)), rotate_r_v(x, 22))
+#define big_sigma1_v(x) wasm_v128_xor(wasm_v128_xor(rotate_r_v(x, 6), rotate_r_v(x, 11)), rotate_r_v(x, 25))
+
+static const uint8_t sha256_zero_block[64];
+
+// load word j..j+3 of 4 blocks, and transpose them so that each vector holds one word of every lane
+static void sha256_x4_load(const uint8_t* const* blocks, uint32_t j, v128_t* w) {
+    v128_t r0 = load_be_v(blocks[0] + j * 4);
+    v128_t r1 = load_be_v(blocks[1] + j * 4);
+    v128_t r2 = load_be_v(blocks[2] + j * 4);
+    v128_t r3 = load_be_v(blocks[3] + j * 4);
+    v128_t t0 = wasm_i32x4_shuffle(r0, r1, 0, 4, 1, 5);
+    v128_t t1 = wasm_i32x4_shuffle(r2, r3, 0, 4, 1, 5);
+    v128_t t2 = wasm_i32x4_shuffle(r0, r1, 2, 6, 3, 7);
+    v128_t t3 = wasm_i32x4_shuffle(r2, r3, 2, 6, 3, 7);
+
+    w[j] = wasm_i32x4_shuffle(t0, t1, 0, 1, 4, 5);
+    w[j + 1] = wasm_i32x4_shuffle(t0, t1, 2, 3, 6, 7);
+    w[j + 2] = wasm_i32x4_shuffle(t2, t3, 0, 1, 4, 5);
+    w[j + 3] = wasm_i32x4_shuffle(t2, t3, 2, 3, 6, 7);
+}
+
+static void sha256_x4_calc_chunk(v128_t* h, const uint8_t* const* blocks) {
+    v128_t w[16];
+    v128_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+    v128_t t1, t2;
+    uint32_t i;
+
+    sha256_x4_load(blocks, 0, w);
+    sha256_x4_load(blocks, 4, w);
+    sha256_x4_load(blocks, 8, w);
+    sha256_x4_load(blocks, 12, w);
+
+    for (i = 0; i < 64; ++i) {
+        if (i >= 16) {
+            w[i & 15] = wasm_i32x4_add(
+                wasm_i32x4_add(w[i & 15], sigma0_v(w[(i + 1) & 15])),
+                wasm_i32x4_add(w[(i + 9) & 15], sigma1_v(w[(i + 14) & 15]))
+            );
+        }
+
+        // ch = (e & f) ^ (~e & g), maj = (a & b) | (c & (a | b))
+        t1 = wasm_i32x4_add(
+            wasm_i32x4_add(hh, big_sigma1_v(e)),
+            wasm_i32x4_add(
+                wasm_v128_xor(wasm_v128_and(e, f), wasm_v128_andnot(g, e)),
+                wasm_i32x4_add(wasm_i32x4_splat(lekkit_k[i]), w[i & 15])
+            )
+        );
+        t2 = wasm_i32x4_add(
+            big_sigma0_v(a),
+            wasm_v128_or(wasm_v128_and(a, b), wasm_v128_and(c, wasm_v128_or(a, b)))
+        );
+
+        hh = g;
+        g = f;
+        f = e;
+        e = wasm_i32x4_add(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = wasm_i32x4_add(t1, t2);
+    }
+
+    h[0] = wasm_i32x4_add(h[0], a);
+    h[1] = wasm_i32x4_add(h[1], b);
+    h[2] = wasm_i32x4_add(h[2], c);
+    h[3] = wasm_i32x4_add(h[3], d);
+    h[4] = wasm_i32x4_add(h[4], e);
+    h[5] = wasm_i32x4_add(h[5], f);
+    h[6] = wasm_i32x4_add(h[6], g);
+    h[7] = wasm_i32x4_add(h[7], hh);
+}
+
+void sha256_x4(const uint8_t* const* data, const uint32_t* length, uint32_t count, uint8_t* out) {
+    // padded last one or two blocks of every lane
+    alignas(16) uint8_t tails[4][128];
+    alignas(16) uint32_t state[8][4];
+    const uint8_t* blocks[4];
+    uint32_t full[4];
+    uint32_t total[4];
+    uint32_t max_total = 0;
+    v128_t h[8];
+    uint32_t lane, step, i, rem;
+    uint64_t bits;
+
+    for (lane = 0; lane < 4; ++lane) {
+        if (lane >= count) {
+            full[lane] = total[lane] = 0;
+            continue;
+        }
+
+        full[lane] = length[lane] / 64;
+        rem = length[lane] % 64;
+        total[lane] = full[lane] + (rem + 9 > 64 ? 2 : 1);
+        if (total[lane] > max_total) max_total = total[lane];
+
+        memset(tails[lane], 0, 128);
+        memcpy(tails[lane], data[lane] + full[lane] * 64, rem);
+        tails[lane][rem] = 0x80;
+
+        bits = (uint64_t) length[lane] * 8;
+        put_unaligned_be32((uint32_t) (bits >> 32), tails[lane] + (total[lane] - full[lane]) * 64 - 8);
+        put_unaligned_be32((uint32_t) bits, tails[lane] + (total[lane] - full[lane]) * 64 - 4);
+    }
+
+    h[0] = wasm_i32x4_splat(0x6a09e667);
+    h[1] = wasm_i32x4_splat(0xbb67ae85);
+    h[2] = wasm_i32x4_splat(0x3c6ef372);
+    h[3] = wasm_i32x4_splat(0xa54ff53a);
+    h[4] = wasm_i32x4_splat(0x510e527f);
+    h[5] = wasm_i32x4_splat(0x9b05688c);
+    h[6] = wasm_i32x4_splat(0x1f83d9ab);
+    h[7] = wasm_i32x4_splat(0x5be0cd19);
+
+    for (step = 0; step < max_total; ++step) {
+        // lanes that are already done keep hashing zeroes, their digest has been saved
+        for (lane = 0; lane < 4; ++lane) {
+            if (step < full[lane]) blocks[lane] = data[lane] + step * 64;
+            else if (step < total[lane]) blocks[lane] = tails[lane] + (step - full[lane]) * 64;
+            else blocks[lane] = sha256_zero_block;
+        }
+
+        sha256_x4_calc_chunk(h, blocks);
+
+        for (lane = 0; lane < count; ++lane) {
+            if (step + 1 != total[lane]) continue;
+
+            for (i = 0; i < 8; ++i) wasm_v128_store(state[i], h[i]);
+            for (i = 0; i < 8; ++i) put_unaligned_be32(state[i][lane], out + lane * SHA256_DIGEST_SIZE + i * 4);
+        }
+    }
+}
+
+#undef big_sigma0_v
+#undef big_sigma1_v
+
+#endif
+
+/*
+ * Hash `count` independent inputs, described by `inputs` as (pointer, length) pairs,
+ * writing the digests one after another to `out`.
+ * The SIMD build hashes up to 4 inputs at once (see sha256_x4)
+ */
+WASM_EXPORT void sha256_multi(const uint32_t* inputs, uint32_t count, uint8_t* out) {
+#ifdef __wasm_simd128__
+    const uint8_t* data[4];
+    uint32_t length[4];
+    uint32_t i, n;
+
+    while (count > 1) {
+        n = MIN(count, 4);
+
+        for (i = 0; i < n; ++i) {
+            data[i] = (const uint8_t*) (size_t) inputs[i * 2];
+            length[i] = inputs[i * 2 + 1];
+        }
+
+        sha256_x4(data, length, n, out);
+
+        inputs += n * 2;
+        out += n * SHA256_DIGEST_SIZE;
+        count -= n;
+    }
+#endif
+
+    struct lekkit_sha256_buff ctx;
+
+    for (; count != 0; --count) {
+        lekkit_sha256_init(&ctx);
+        lekkit_sha256_update(&ctx, (const void*) (size_t) inputs[0], inputs[1]);
+        lekkit_sha256_finalize(&ctx);
+        lekkit_sha256_read(&ctx, out);
+
+        inputs += 2;
+        out += SHA256_DIGEST_SIZE;
+    }
+}
+
+/*
+ * Hash the concatenation of `count` slices, described by `iov` as (pointer, length) pairs
+ */
+WASM_EXPORT void sha256_iov(const uint32_t* iov, uint32_t count, uint8_t* out) {
+    struct lekkit_sha256_buff ctx;
+
+    lekkit_sha256_init(&ctx);
+
+    for (; count != 0; --count, iov += 2) {
+        lekkit_sha256_update(&ctx, (const void*) (size_t) iov[0], iov[1]);
+    }
+
+    lekkit_sha256_finalize(&ctx);
+    lekkit_sha256_read(&ctx, out);
+}
+
+/*
+ * Streaming API. Contexts are allocated in the module heap, and must be freed with sha256_free.
+ * sha256_final writes the digest to `out` and re-initializes the context, so it can be reused
+ */
+
+WASM_EXPORT struct lekkit_sha256_buff* sha256_alloc() {
+    struct lekkit_sha256_buff* ctx = (struct lekkit_sha256_buff*) __malloc(sizeof(struct lekkit_sha256_buff));
+    lekkit_sha256_init(ctx);
+
+    return ctx;
+}
+
+WASM_EXPORT struct lekkit_sha256_buff* sha256_clone(const struct lekkit_sha256_buff* ctx) {
+    struct lekkit_sha256_buff* copy = (struct lekkit_sha256_buff*) __malloc(sizeof(struct lekkit_sha256_buff));
+    __builtin_memcpy(copy, ctx, sizeof(struct lekkit_sha256_buff));
+
+    return copy;
+}
+
+WASM_EXPORT void sha256_free(struct lekkit_sha256_buff* ctx) {
+    __free(ctx);
+}
+
+WASM_EXPORT void sha256_reset(struct lekkit_sha256_buff* ctx) {
+    lekkit_sha256_init(ctx);
+}
+
+WASM_EXPORT void sha256_update(struct lekkit_sha256_buff* ctx, const void* data, uint32_t size) {
+    lekkit_sha256_update(ctx, data, size);
+}
+
+WASM_EXPORT void sha256_final(struct lekkit_sha256_buff* ctx, uint8_t* out) {
+    lekkit_sha256_finalize(ctx);
+    lekkit_sha256_read(ctx, out);
+    lekkit_sha256_init(ctx);
+}
+
+#undef rotate_r
+
+#ifdef __wasm_simd128__
+#undef rotate_r_v
+#undef sigma0_v
+#undef sigma1_v
+#undef load_be_v
+#endif
\ No newline at end of file
@@ -0,0 +1,25 @@
+#include "wasm.h"
+
+#ifndef SHA256_H
+#define SHA256_H
+
+#define SHA256_DIGEST_SIZE 32
+
+struct lekkit_sha256_buff {
+    uint64_t data_size;
+    uint32_t h[8];
+    uint8_t last_chunk[64];
+    uint8_t chunk_size;
+};
+
+void lekkit_sha256_init(struct lekkit_sha256_buff* buff);
+void lekkit_sha256_update(struct lekkit_sha256_buff* buff, const void* data, uint32_t size);
+void lekkit_sha256_finalize(struct lekkit_sha256_buff* buff);
+void lekkit_sha256_read(const struct lekkit_sha256_buff* buff, uint8_t* hash);
+
+#ifdef __wasm_simd128__
+// hash up to 4 independent inputs at once, in i32x4 lanes. digests are written one after another to `out`
+void sha256_x4(const uint8_t* const* data, const uint32_t* length, uint32_t count, uint8_t* out);
+#endif
+
+#endif // SHA256_H
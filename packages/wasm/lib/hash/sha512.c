@@ -0,0 +1,274 @@
+#include "sha512.h"
+#include <stdalign.h>
+
+/*
+ * SHA-512 with a streaming context.
+ *
+ * The rounds are unrolled 8 at a time, with the working variables rotated through
+ * the macro arguments. The message schedule is computed on the fly in a rolling window
+ * of 16 words, or (in the SIMD build) precomputed 2 words at a time in i64x2 lanes,
+ * together with the round constants.
+ */
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+static const alignas(16) uint64_t sha512_k[80] = {
+    0x428a2f98d728ae22, 0x7137449123ef65cd, 0xb5c0fbcfec4d3b2f, 0xe9b5dba58189dbbc,
+    0x3956c25bf348b538, 0x59f111f1b605d019, 0x923f82a4af194f9b, 0xab1c5ed5da6d8118,
+    0xd807aa98a3030242, 0x12835b0145706fbe, 0x243185be4ee4b28c, 0x550c7dc3d5ffb4e2,
+    0x72be5d74f27b896f, 0x80deb1fe3b1696b1, 0x9bdc06a725c71235, 0xc19bf174cf692694,
+    0xe49b69c19ef14ad2, 0xefbe4786384f25e3, 0x0fc19dc68b8cd5b5, 0x240ca1cc77ac9c65,
+    0x2de92c6f592b0275, 0x4a7484aa6ea6e483, 0x5cb0a9dcbd41fbd4, 0x76f988da831153b5,
+    0x983e5152ee66dfab, 0xa831c66d2db43210, 0xb00327c898fb213f, 0xbf597fc7beef0ee4,
+    0xc6e00bf33da88fc2, 0xd5a79147930aa725, 0x06ca6351e003826f, 0x142929670a0e6e70,
+    0x27b70a8546d22ffc, 0x2e1b21385c26c926, 0x4d2c6dfc5ac42aed, 0x53380d139d95b3df,
+    0x650a73548baf63de, 0x766a0abb3c77b2a8, 0x81c2c92e47edaee6, 0x92722c851482353b,
+    0xa2bfe8a14cf10364, 0xa81a664bbc423001, 0xc24b8b70d0f89791, 0xc76c51a30654be30,
+    0xd192e819d6ef5218, 0xd69906245565a910, 0xf40e35855771202a, 0x106aa07032bbd1b8,
+    0x19a4c116b8d2d0c8, 0x1e376c085141ab53, 0x2748774cdf8eeb99, 0x34b0bcb5e19b48a8,
+    0x391c0cb3c5c95a63, 0x4ed8aa4ae3418acb, 0x5b9cca4f7763e373, 0x682e6ff3d6b2b8a3,
+    0x748f82ee5defb2fc, 0x78a5636f43172f60, 0x84c87814a1f0ab72, 0x8cc702081a6439ec,
+    0x90befffa23631e28, 0xa4506cebde82bde9, 0xbef9a3f7b2c67915, 0xc67178f2e372532b,
+    0xca273eceea26619c, 0xd186b8c721c0c207, 0xeada7dd6cde0eb1e, 0xf57d4f7fee6ed178,
+    0x06f067aa72176fba, 0x0a637dc5a2c898a6, 0x113f9804bef90dae, 0x1b710b35131c471b,
+    0x28db77f523047d84, 0x32caab7b40c72493, 0x3c9ebe0a15c9bebc, 0x431d67c49c100d4c,
+    0x4cc5d4becb3e42b6, 0x597f299cfc657e2a, 0x5fcb6fab3ad6faec, 0x6c44198c4a475817,
+};
+
+#define ROR(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+#define S0(x) (ROR(x, 28) ^ ROR(x, 34) ^ ROR(x, 39))
+#define S1(x) (ROR(x, 14) ^ ROR(x, 18) ^ ROR(x, 41))
+#define s0(x) (ROR(x, 1) ^ ROR(x, 8) ^ ((x) >> 7))
+#define s1(x) (ROR(x, 19) ^ ROR(x, 61) ^ ((x) >> 6))
+
+#define CH(e, f, g) ((g) ^ ((e) & ((f) ^ (g))))
+#define MAJ(a, b, c) (((a) & (b)) | ((c) & ((a) | (b))))
+
+#define ROUND(a, b, c, d, e, f, g, h, wk) do { \
+    uint64_t t = h + S1(e) + CH(e, f, g) + (wk); \
+    d += t; \
+    h = t + S0(a) + MAJ(a, b, c); \
+} while (0)
+
+// eight rounds bring the working variables back to their original order
+#define ROUND8(WK, i) \
+    ROUND(a, b, c, d, e, f, g, h, WK(i)); \
+    ROUND(h, a, b, c, d, e, f, g, WK(i + 1)); \
+    ROUND(g, h, a, b, c, d, e, f, WK(i + 2)); \
+    ROUND(f, g, h, a, b, c, d, e, WK(i + 3)); \
+    ROUND(e, f, g, h, a, b, c, d, WK(i + 4)); \
+    ROUND(d, e, f, g, h, a, b, c, WK(i + 5)); \
+    ROUND(c, d, e, f, g, h, a, b, WK(i + 6)); \
+    ROUND(b, c, d, e, f, g, h, a, WK(i + 7));
+
+#ifdef __wasm_simd128__
+
+#define ROR_V(x, n) wasm_v128_or(wasm_u64x2_shr(x, n), wasm_i64x2_shl(x, 64 - n))
+
+// w[t..t+1] only depend on w[t-2..t-1] and older words, so the schedule maps onto i64x2 lanes directly
+static void sha512_schedule(const uint64_t* block, uint64_t* wk) {
+    alignas(16) uint64_t w[80];
+    v128_t x, y;
+    uint32_t i;
+
+    for (i = 0; i < 16; i += 2) {
+        x = wasm_v128_load(&block[i]);
+        wasm_v128_store(&w[i], x);
+        wasm_v128_store(&wk[i], wasm_i64x2_add(x, wasm_v128_load(&sha512_k[i])));
+    }
+
+    for (i = 16; i < 80; i += 2) {
+        x = wasm_v128_load(&w[i - 2]);
+        y = wasm_v128_load(&w[i - 15]);
+
+        x = wasm_v128_xor(wasm_v128_xor(ROR_V(x, 19), ROR_V(x, 61)), wasm_u64x2_shr(x, 6));
+        y = wasm_v128_xor(wasm_v128_xor(ROR_V(y, 1), ROR_V(y, 8)), wasm_u64x2_shr(y, 7));
+
+        x = wasm_i64x2_add(
+            wasm_i64x2_add(x, wasm_v128_load(&w[i - 7])),
+            wasm_i64x2_add(y, wasm_v128_load(&w[i - 16]))
+        );
+
+        wasm_v128_store(&w[i], x);
+        wasm_v128_store(&wk[i], wasm_i64x2_add(x, wasm_v128_load(&sha512_k[i])));
+    }
+}
+
+#undef ROR_V
+
+#define WK(i) wk[i]
+
+void sha512_compress(uint64_t* state, const uint64_t* block) {
+    alignas(16) uint64_t wk[80];
+    uint64_t a, b, c, d, e, f, g, h;
+    uint32_t i;
+
+    sha512_schedule(block, wk);
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    for (i = 0; i < 80; i += 8) {
+        ROUND8(WK, i)
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+#else
+
+#define W(i) w[(i) & 15]
+#define WK_LOAD(i) (W(i) = block[i]) + sha512_k[i]
+#define WK(i) (W(i) += s1(W((i) + 14)) + W((i) + 9) + s0(W((i) + 1))) + sha512_k[i]
+
+void sha512_compress(uint64_t* state, const uint64_t* block) {
+    uint64_t w[16];
+    uint64_t a, b, c, d, e, f, g, h;
+    uint32_t i;
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    ROUND8(WK_LOAD, 0)
+    ROUND8(WK_LOAD, 8)
+
+    for (i = 16; i < 80; i += 8) {
+        ROUND8(WK, i)
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+#undef W
+#undef WK_LOAD
+
+#endif
+
+static void sha512_blocks(uint64_t* h, const uint8_t* data, uint32_t blocks) {
+    uint64_t w[16];
+    uint32_t i;
+
+    for (; blocks != 0; --blocks, data += SHA512_BLOCK_SIZE) {
+        for (i = 0; i < 16; i++) {
+            w[i] = be64_bswap(load_u64_unaligned(data + i * 8));
+        }
+
+        sha512_compress(h, w);
+    }
+}
+
+void sha512_init(struct sha512_ctx* ctx) {
+    ctx->h[0] = 0x6a09e667f3bcc908;
+    ctx->h[1] = 0xbb67ae8584caa73b;
+    ctx->h[2] = 0x3c6ef372fe94f82b;
+    ctx->h[3] = 0xa54ff53a5f1d36f1;
+    ctx->h[4] = 0x510e527fade682d1;
+    ctx->h[5] = 0x9b05688c2b3e6c1f;
+    ctx->h[6] = 0x1f83d9abfb41bd6b;
+    ctx->h[7] = 0x5be0cd19137e2179;
+    ctx->data_size = 0;
+    ctx->buffer_size = 0;
+}
+
+void sha512_update(struct sha512_ctx* ctx, const uint8_t* data, uint32_t size) {
+    uint32_t n;
+
+    ctx->data_size += size;
+
+    // complete the block buffered by the previous call
+    if (ctx->buffer_size != 0) {
+        n = MIN(size, SHA512_BLOCK_SIZE - ctx->buffer_size);
+        memcpy(ctx->buffer + ctx->buffer_size, data, n);
+        ctx->buffer_size += n;
+        data += n;
+        size -= n;
+
+        if (ctx->buffer_size < SHA512_BLOCK_SIZE) return;
+
+        sha512_blocks(ctx->h, ctx->buffer, 1);
+        ctx->buffer_size = 0;
+    }
+
+    if (size >= SHA512_BLOCK_SIZE) {
+        sha512_blocks(ctx->h, data, size / SHA512_BLOCK_SIZE);
+        data += size & ~(SHA512_BLOCK_SIZE - 1);
+        size &= SHA512_BLOCK_SIZE - 1;
+    }
+
+    memcpy(ctx->buffer, data, size);
+    ctx->buffer_size = size;
+}
+
+void sha512_final(struct sha512_ctx* ctx, uint8_t* out) {
+    uint32_t n = ctx->buffer_size;
+    uint64_t bits = ctx->data_size * 8;
+    uint32_t i;
+
+    ctx->buffer[n++] = 0x80;
+
+    // not enough space for the length, it goes to the next block
+    if (n > SHA512_BLOCK_SIZE - 16) {
+        memset(ctx->buffer + n, 0, SHA512_BLOCK_SIZE - n);
+        sha512_blocks(ctx->h, ctx->buffer, 1);
+        n = 0;
+    }
+
+    // the length is a 128-bit number, but inputs are limited to 4 GB anyway
+    memset(ctx->buffer + n, 0, SHA512_BLOCK_SIZE - 8 - n);
+    store_u64_unaligned(be64_bswap(bits), ctx->buffer + SHA512_BLOCK_SIZE - 8);
+    sha512_blocks(ctx->h, ctx->buffer, 1);
+
+    for (i = 0; i < 8; i++) {
+        store_u64_unaligned(be64_bswap(ctx->h[i]), out + i * 8);
+    }
+
+    sha512_init(ctx);
+}
+
+WASM_EXPORT void sha512(const uint8_t* data, uint32_t size) {
+    struct sha512_ctx ctx;
+
+    sha512_init(&ctx);
+    sha512_update(&ctx, data, size);
+    sha512_final(&ctx, shared_out);
+}
+
+#undef ROR
+#undef S0
+#undef S1
+#undef s0
+#undef s1
+#undef CH
+#undef MAJ
+#undef ROUND
+#undef ROUND8
+#undef WK
@@ -0,0 +1,27 @@
+#include "wasm.h"
+
+#ifndef SHA512_H
+#define SHA512_H
+
+#define SHA512_DIGEST_SIZE 64
+#define SHA512_BLOCK_SIZE 128
+
+struct sha512_ctx {
+    uint64_t h[8];
+    uint64_t data_size;
+    uint32_t buffer_size;
+    uint8_t buffer[SHA512_BLOCK_SIZE];
+};
+
+void sha512_init(struct sha512_ctx* ctx);
+void sha512_update(struct sha512_ctx* ctx, const uint8_t* data, uint32_t size);
+// writes the digest to `out` and re-initializes the context
+void sha512_final(struct sha512_ctx* ctx, uint8_t* out);
+
+// process a single block, given as 16 already decoded big-endian words
+void sha512_compress(uint64_t* h, const uint64_t* w);
+
+// one-shot SHA-512, the digest is written to `shared_out`
+void sha512(const uint8_t* data, uint32_t size);
+
+#endif // SHA512_H
@@ -91,7 +91,13 @@ adler32_generic(u32 adler, const u8 *p, size_t len)
 #undef arch_select_adler32_func
 typedef u32 (*adler32_func_t)(u32 adler, const u8 *p, size_t len);
 
-#define DEFAULT_IMPL adler32_generic
+#ifdef __wasm_simd128__
+#  include "adler32_wasm_impl.h"
+#endif
+
+#ifndef DEFAULT_IMPL
+#  define DEFAULT_IMPL adler32_generic
+#endif
 
 #ifdef arch_select_adler32_func
 static u32 dispatch_adler32(u32 adler, const u8 *p, size_t len);
@@ -0,0 +1,82 @@
+/*
+ * adler32_wasm_impl.h - WebAssembly SIMD implementation of Adler-32
+ */
+
+#ifndef LIB_ADLER32_WASM_IMPL_H
+#define LIB_ADLER32_WASM_IMPL_H
+
+#include <wasm_simd128.h>
+
+static inline u32
+adler32_wasm_hsum(v128_t v)
+{
+	return (u32)wasm_i32x4_extract_lane(v, 0) +
+	       (u32)wasm_i32x4_extract_lane(v, 1) +
+	       (u32)wasm_i32x4_extract_lane(v, 2) +
+	       (u32)wasm_i32x4_extract_lane(v, 3);
+}
+
+/*
+ * Process 32 bytes per iteration.  For a block of n bytes, s2 grows by
+ * n * s1 plus the sum of the bytes weighted by their distance from the end of
+ * the block.  Within a 32-byte block, the weights (32..1) are applied with
+ * 16-bit dot products, and the contribution of the previous blocks of the chunk
+ * is tracked by summing the running byte sums (v_s1_sums) and multiplying by 32
+ * at the end of the chunk.
+ *
+ * Chunks are limited to MAX_CHUNK_LEN rounded down to a multiple of 32, so all
+ * partial sums fit into 32 bits, the same as in adler32_generic().
+ */
+static u32
+adler32_wasm_simd(u32 adler, const u8 *p, size_t len)
+{
+	const v128_t zero = wasm_i32x4_splat(0);
+	const v128_t weights_a = wasm_i16x8_make(32, 31, 30, 29, 28, 27, 26, 25);
+	const v128_t weights_b = wasm_i16x8_make(24, 23, 22, 21, 20, 19, 18, 17);
+	const v128_t weights_c = wasm_i16x8_make(16, 15, 14, 13, 12, 11, 10, 9);
+	const v128_t weights_d = wasm_i16x8_make(8, 7, 6, 5, 4, 3, 2, 1);
+	u32 s1 = adler & 0xFFFF;
+	u32 s2 = adler >> 16;
+
+	while (len >= 32) {
+		size_t n = MIN(len, MAX_CHUNK_LEN & ~31) & ~31;
+		v128_t v_s1 = zero;
+		v128_t v_s1_sums = zero;
+		v128_t v_s2 = zero;
+
+		s2 += s1 * n;
+		len -= n;
+
+		do {
+			const v128_t bytes_a = wasm_v128_load(p);
+			const v128_t bytes_b = wasm_v128_load(p + 16);
+
+			v_s1_sums = wasm_i32x4_add(v_s1_sums, v_s1);
+			v_s1 = wasm_i32x4_add(v_s1,
+				wasm_u32x4_extadd_pairwise_u16x8(wasm_i16x8_add(
+					wasm_u16x8_extadd_pairwise_u8x16(bytes_a),
+					wasm_u16x8_extadd_pairwise_u8x16(bytes_b))));
+			v_s2 = wasm_i32x4_add(v_s2, wasm_i32x4_add(
+				wasm_i32x4_dot_i16x8(wasm_u16x8_extend_low_u8x16(bytes_a), weights_a),
+				wasm_i32x4_dot_i16x8(wasm_u16x8_extend_high_u8x16(bytes_a), weights_b)));
+			v_s2 = wasm_i32x4_add(v_s2, wasm_i32x4_add(
+				wasm_i32x4_dot_i16x8(wasm_u16x8_extend_low_u8x16(bytes_b), weights_c),
+				wasm_i32x4_dot_i16x8(wasm_u16x8_extend_high_u8x16(bytes_b), weights_d)));
+
+			p += 32;
+			n -= 32;
+		} while (n != 0);
+
+		s1 += adler32_wasm_hsum(v_s1);
+		s2 += (adler32_wasm_hsum(v_s1_sums) << 5) + adler32_wasm_hsum(v_s2);
+
+		s1 %= DIVISOR;
+		s2 %= DIVISOR;
+	}
+
+	return adler32_generic((s2 << 16) | s1, p, len);
+}
+
+#define DEFAULT_IMPL adler32_wasm_simd
+
+#endif /* LIB_ADLER32_WASM_IMPL_H */
@@ -0,0 +1,106 @@
+#include "deflate_constants.h"
+
+#define MATCHFINDER_WINDOW_ORDER DEFLATE_WINDOW_ORDER
+#include "ht_matchfinder.h"
+
+/*
+ * Cheap estimate of how well some data would deflate, to decide whether compressing it is worth it at all.
+ *
+ * A sample from the middle of the data is parsed greedily with the same matchfinder the fastest compression
+ * level uses. Literals are costed at the order-0 entropy of their histogram, matches at the approximate size
+ * of their length and offset codes. This is a single pass over at most ESTIMATE_SAMPLE_SIZE bytes,
+ * instead of actually compressing (and then throwing away) a part of the data.
+ */
+
+#define ESTIMATE_SAMPLE_SIZE 8192
+#define ESTIMATE_NICE_LEN 32
+
+// a length symbol is ~7 bits and an offset symbol ~5 bits, plus extra bits for the offset
+#define MATCH_BASE_COST 12
+
+// the matchfinder table is 128 KB, so it's allocated on first use and kept around
+static struct ht_matchfinder* estimate_mf = NULL;
+
+// log2(x) * 256, linearly interpolated between powers of two (error is at most ~0.09)
+static uint32_t log2_fixed(uint32_t x) {
+    uint32_t e = bsr32(x);
+
+    return (e << 8) + (((x << 8) >> e) - 256);
+}
+
+/*
+ * Returns the estimated ratio of compressed to original size, multiplied by 1024 (and capped at 1024).
+ * Only the middle ESTIMATE_SAMPLE_SIZE bytes of the data are looked at
+ */
+WASM_EXPORT uint32_t estimate_compressibility(const uint8_t* data, uint32_t size) {
+    uint32_t histogram[256];
+    const uint8_t* in_base;
+    const uint8_t* in_next;
+    const uint8_t* in_end;
+    uint32_t next_hash = 0;
+    uint32_t literals = 0;
+    uint32_t match_bits = 0;
+    uint32_t literal_bits, i;
+    uint64_t total_bits;
+
+    if (size > ESTIMATE_SAMPLE_SIZE) {
+        data += (size - ESTIMATE_SAMPLE_SIZE) / 2;
+        size = ESTIMATE_SAMPLE_SIZE;
+    }
+
+    if (size < HT_MATCHFINDER_REQUIRED_NBYTES) return 1024;
+
+    if (estimate_mf == NULL) {
+        estimate_mf = libdeflate_aligned_malloc(MATCHFINDER_MEM_ALIGNMENT, sizeof(struct ht_matchfinder));
+    }
+
+    ht_matchfinder_init(estimate_mf);
+    memset(histogram, 0, sizeof(histogram));
+
+    in_base = data;
+    in_next = data;
+    in_end = data + size;
+
+    while (in_next != in_end) {
+        uint32_t max_len = MIN(in_end - in_next, DEFLATE_MAX_MATCH_LEN);
+        uint32_t length, offset;
+
+        if (max_len < HT_MATCHFINDER_REQUIRED_NBYTES) {
+            while (in_next != in_end) histogram[*in_next++]++;
+            literals += max_len;
+            break;
+        }
+
+        length = ht_matchfinder_longest_match(estimate_mf, &in_base, in_next, max_len,
+                                              MIN(ESTIMATE_NICE_LEN, max_len), &next_hash, &offset);
+
+        if (length) {
+            match_bits += MATCH_BASE_COST + bsr32(offset);
+            ht_matchfinder_skip_bytes(estimate_mf, &in_base, in_next + 1, in_end, length - 1, &next_hash);
+            in_next += length;
+        } else {
+            histogram[*in_next++]++;
+            literals++;
+        }
+    }
+
+    // sum of -log2(count / literals) over all literals
+    literal_bits = 0;
+    if (literals != 0) {
+        literal_bits = literals * log2_fixed(literals);
+        for (i = 0; i < 256; i++) {
+            if (histogram[i] != 0) literal_bits -= histogram[i] * log2_fixed(histogram[i]);
+        }
+    }
+
+    // a huffman code can't spend less than a bit per literal
+    literal_bits = MAX(literal_bits >> 8, literals);
+
+    total_bits = (uint64_t) literal_bits + match_bits;
+
+    return MIN(total_bits * 1024 / (size * 8), 1024);
+}
+
+#undef ESTIMATE_SAMPLE_SIZE
+#undef ESTIMATE_NICE_LEN
+#undef MATCH_BASE_COST
@@ -586,7 +586,29 @@ have_decode_tables:
 		 * been ensured there is enough output space left for a slight
 		 * overrun.  FASTLOOP_MAX_BYTES_WRITTEN needs to be updated if
 		 * the maximum possible overrun here is changed.
+		 *
+		 * With SIMD, offsets of at least 16 and RLE matches are copied
+		 * 16 bytes at a time instead.  The overrun is at most 15 bytes,
+		 * which fits into the slack FASTLOOP_MAX_BYTES_WRITTEN reserves
+		 * for the 5-word copies.
 		 */
+#ifdef __wasm_simd128__
+		STATIC_ASSERT(5 * WORDBYTES >= 16);
+		if (offset >= 16) {
+			do {
+				wasm_v128_store(dst, wasm_v128_load(src));
+				src += 16;
+				dst += 16;
+			} while (dst < out_next);
+		} else if (offset == 1) {
+			const v128_t v = wasm_i8x16_splat(src[0]);
+
+			do {
+				wasm_v128_store(dst, v);
+				dst += 16;
+			} while (dst < out_next);
+		} else
+#endif
 		if (UNALIGNED_ACCESS_IS_FAST && offset >= WORDBYTES) {
 			store_word_unaligned(load_word_unaligned(src), dst);
 			src += WORDBYTES;
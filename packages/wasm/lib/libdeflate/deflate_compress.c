@@ -463,6 +463,13 @@ struct libdeflate_compressor {
 	/* Anything of this size or less we won't bother trying to compress. */
 	size_t max_passthrough_size;
 
+	/*
+	 * Set while compressing a segment that isn't the last one: no block is
+	 * marked as final, so another segment can follow (see
+	 * libdeflate_deflate_compress_segment()).
+	 */
+	bool sync_flush;
+
 	/*
 	 * The maximum search depth: consider at most this many potential
 	 * matches at each position
@@ -1739,6 +1746,9 @@ deflate_flush_block(struct libdeflate_compressor *c,
 	ASSERT(out_next <= os->end);
 	ASSERT(!os->overflow);
 
+	if (c->sync_flush)
+		is_final_block = false;
+
 	/* Precompute the precode items and build the precode. */
 	deflate_precompute_huffman_header(c);
 
@@ -2387,7 +2397,7 @@ choose_max_block_end(const u8 *in_block_begin, const u8 *in_end,
  */
 static size_t
 deflate_compress_none(const u8 *in, size_t in_nbytes,
-		      u8 *out, size_t out_nbytes_avail)
+		      u8 *out, size_t out_nbytes_avail, bool is_final)
 {
 	const u8 *in_next = in;
 	const u8 * const in_end = in + in_nbytes;
@@ -2403,7 +2413,7 @@ deflate_compress_none(const u8 *in, size_t in_nbytes,
 		if (out_nbytes_avail < 5)
 			return 0;
 		/* BFINAL and BTYPE */
-		*out_next++ = 1 | (DEFLATE_BLOCKTYPE_UNCOMPRESSED << 1);
+		*out_next++ = is_final | (DEFLATE_BLOCKTYPE_UNCOMPRESSED << 1);
 		/* LEN and NLEN */
 		put_unaligned_le32(0xFFFF0000, out_next);
 		return 5;
@@ -2414,7 +2424,7 @@ deflate_compress_none(const u8 *in, size_t in_nbytes,
 		size_t len = UINT16_MAX;
 
 		if (in_end - in_next <= UINT16_MAX) {
-			bfinal = 1;
+			bfinal = is_final;
 			len = in_end - in_next;
 		}
 		if (out_end - out_next < 5 + len)
@@ -3901,6 +3911,7 @@ libdeflate_alloc_compressor_ex(int compression_level,
 		return NULL;
 
 	c->compression_level = compression_level;
+	c->sync_flush = false;
 
 	/*
 	 * The higher the compression level, the more we should bother trying to
@@ -4011,10 +4022,10 @@ libdeflate_alloc_compressor(int compression_level)
 	return libdeflate_alloc_compressor_ex(compression_level, &defaults);
 }
 
-size_t
-libdeflate_deflate_compress(struct libdeflate_compressor *c,
-			    const void *in, size_t in_nbytes,
-			    void *out, size_t out_nbytes_avail)
+static size_t
+deflate_compress_segment(struct libdeflate_compressor *c,
+			 const void *in, size_t in_nbytes,
+			 void *out, size_t out_nbytes_avail, bool is_final)
 {
 	struct deflate_output_bitstream os;
 
@@ -4024,7 +4035,7 @@ libdeflate_deflate_compress(struct libdeflate_compressor *c,
 	 */
 	if (unlikely(in_nbytes <= c->max_passthrough_size))
 		return deflate_compress_none(in, in_nbytes,
-					     out, out_nbytes_avail);
+					     out, out_nbytes_avail, is_final);
 
 	/* Initialize the output bitstream structure. */
 	os.bitbuf = 0;
@@ -4034,12 +4045,33 @@ libdeflate_deflate_compress(struct libdeflate_compressor *c,
 	os.overflow = false;
 
 	/* Call the actual compression function. */
+	c->sync_flush = !is_final;
 	(*c->impl)(c, in, in_nbytes, &os);
+	c->sync_flush = false;
 
 	/* Return 0 if the output buffer is too small. */
 	if (os.overflow)
 		return 0;
 
+	if (!is_final) {
+		/*
+		 * Byte-align the stream with an empty uncompressed block, so
+		 * that the next segment can start at a byte boundary.  Its
+		 * BFINAL and BTYPE bits are all zero, as is the padding.
+		 */
+		size_t nbytes = DIV_ROUND_UP(os.bitcount + 3, 8);
+
+		if (os.end - os.next < nbytes + 4)
+			return 0;
+		*os.next++ = os.bitbuf;
+		if (nbytes > 1)
+			*os.next++ = 0;
+		put_unaligned_le32(0xFFFF0000, os.next);
+		os.next += 4;
+
+		return os.next - (u8 *)out;
+	}
+
 	/*
 	 * Write the final byte if needed.  This can't overflow the output
 	 * buffer because deflate_flush_block() would have set the overflow flag
@@ -4055,6 +4087,31 @@ libdeflate_deflate_compress(struct libdeflate_compressor *c,
 	return os.next - (u8 *)out;
 }
 
+size_t
+libdeflate_deflate_compress(struct libdeflate_compressor *c,
+			    const void *in, size_t in_nbytes,
+			    void *out, size_t out_nbytes_avail)
+{
+	return deflate_compress_segment(c, in, in_nbytes,
+					out, out_nbytes_avail, true);
+}
+
+/*
+ * Compress one segment of a DEFLATE stream that is produced in parts.  Each
+ * segment is compressed independently (matches don't reach into the previous
+ * segments), and all but the last one end with a byte-aligned empty
+ * uncompressed block instead of a final block, like zlib's Z_SYNC_FLUSH.
+ */
+size_t
+libdeflate_deflate_compress_segment(struct libdeflate_compressor *c,
+				    const void *in, size_t in_nbytes,
+				    void *out, size_t out_nbytes_avail,
+				    bool is_final)
+{
+	return deflate_compress_segment(c, in, in_nbytes,
+					out, out_nbytes_avail, is_final);
+}
+
 void
 libdeflate_free_compressor(struct libdeflate_compressor *c)
 {
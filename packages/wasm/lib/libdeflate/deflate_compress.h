@@ -15,6 +15,10 @@ size_t libdeflate_deflate_compress(struct libdeflate_compressor *c,
           const void *in, size_t in_nbytes,
           void *out, size_t out_nbytes_avail);
 
+size_t libdeflate_deflate_compress_segment(struct libdeflate_compressor *c,
+          const void *in, size_t in_nbytes,
+          void *out, size_t out_nbytes_avail, bool is_final);
+
 size_t libdeflate_deflate_compress_bound(struct libdeflate_compressor *c, size_t in_nbytes);
 
 #endif /* LIB_DEFLATE_COMPRESS_H */
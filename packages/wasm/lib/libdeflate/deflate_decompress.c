@@ -45,6 +45,10 @@
 #include "lib_common.h"
 #include "deflate_constants.h"
 
+#ifdef __wasm_simd128__
+#  include <wasm_simd128.h>
+#endif
+
 /*
  * If the expression passed to SAFETY_CHECK() evaluates to false, then the
  * decompression routine immediately returns LIBDEFLATE_BAD_DATA, indicating the
@@ -1081,7 +1085,8 @@ typedef enum libdeflate_result (*decompress_func_t)
 /* Include architecture-specific implementation(s) if available. */
 #undef DEFAULT_IMPL
 #undef arch_select_decompress_func
-#if defined(ARCH_X86_32) || defined(ARCH_X86_64)
+/* x86/ isn't vendored, the native benchmark build defines LIBDEFLATE_NO_ARCH_IMPL to skip it */
+#if (defined(ARCH_X86_32) || defined(ARCH_X86_64)) && !defined(LIBDEFLATE_NO_ARCH_IMPL)
 #  include "x86/decompress_impl.h"
 #endif
 
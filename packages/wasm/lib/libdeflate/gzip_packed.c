@@ -0,0 +1,57 @@
+#include "lib_common.h"
+
+/*
+ * Serialization of a gzip_packed#3072cfa1 TL object: the constructor, the bytes length header,
+ * the zlib stream and the padding to a multiple of 4, all written by a single call so that
+ * the compressed data doesn't have to be copied around in JS just to frame it.
+ */
+
+#define GZIP_PACKED_ID 0x3072cfa1
+
+// constructor + long length header
+#define GZIP_PACKED_HEADER_SIZE 8
+// at most 3 bytes of padding are needed after the data
+#define GZIP_PACKED_MAX_PADDING 3
+
+/*
+ * Compresses `in` and writes the complete gzip_packed object to `out`.
+ * Returns the number of bytes written, or 0 if the object doesn't fit into `out_nbytes_avail` bytes
+ */
+WASM_EXPORT size_t gzip_packed_compress(
+    struct libdeflate_compressor* c,
+    const uint8_t* in,
+    size_t in_nbytes,
+    uint8_t* out,
+    size_t out_nbytes_avail
+) {
+    size_t size, total;
+
+    if (out_nbytes_avail <= GZIP_PACKED_HEADER_SIZE + GZIP_PACKED_MAX_PADDING) return 0;
+
+    // the long header is assumed while compressing, the data is moved back if the short one is enough
+    size = libdeflate_zlib_compress(
+        c, in, in_nbytes,
+        out + GZIP_PACKED_HEADER_SIZE,
+        out_nbytes_avail - GZIP_PACKED_HEADER_SIZE - GZIP_PACKED_MAX_PADDING
+    );
+    if (size == 0 || size > 0xffffff) return 0;
+
+    put_unaligned_le32(GZIP_PACKED_ID, out);
+
+    if (size < 254) {
+        out[4] = size;
+        __builtin_memmove(out + 5, out + GZIP_PACKED_HEADER_SIZE, size);
+        total = 5 + size;
+    } else {
+        put_unaligned_le32((size << 8) | 254, out + 4);
+        total = GZIP_PACKED_HEADER_SIZE + size;
+    }
+
+    while (total & 3) out[total++] = 0;
+
+    return total;
+}
+
+#undef GZIP_PACKED_ID
+#undef GZIP_PACKED_HEADER_SIZE
+#undef GZIP_PACKED_MAX_PADDING
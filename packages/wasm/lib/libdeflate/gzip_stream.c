@@ -0,0 +1,612 @@
+#include "wasm.h"
+#include "deflate_constants.h"
+#include "gzip_constants.h"
+
+/*
+ * Resumable gzip decompressor. libdeflate only works on whole buffers and needs the entire
+ * output to be allocated up front (and its size is taken from the attacker-controlled ISIZE trailer),
+ * so for large inputs we use this instead: input is pushed in arbitrary chunks and output is pulled
+ * in chunks of the caller's choosing, so the memory used is bounded by the chunk sizes
+ * plus a fixed ~36 KB context, no matter how large the decompressed data is.
+ *
+ * Every decoding step is atomic: if there are not enough bits to complete it, nothing is consumed
+ * and the step is retried after more input is pushed.
+ */
+
+#define WINDOW_SIZE DEFLATE_MAX_MATCH_OFFSET
+#define WINDOW_MASK (WINDOW_SIZE - 1)
+
+#define FAST_BITS 9
+#define FAST_MASK ((1 << FAST_BITS) - 1)
+
+#define GUNZIP_ERR_BAD_DATA -1
+#define GUNZIP_ERR_TOO_LARGE -2
+#define GUNZIP_ERR_NO_MEMORY -3
+
+enum {
+    ST_HEADER,
+    ST_HEADER_REST,
+    ST_EXTRA_LEN,
+    ST_EXTRA,
+    ST_NAME,
+    ST_COMMENT,
+    ST_HCRC,
+    ST_BLOCK_HEADER,
+    ST_STORED_LEN,
+    ST_STORED,
+    ST_TABLE_COUNTS,
+    ST_PRECODE_LENS,
+    ST_CODE_LENS,
+    ST_CODES,
+    ST_MATCH,
+    ST_TRAILER,
+    ST_DONE,
+    ST_ERROR,
+};
+
+// canonical huffman code. `fast` maps the next FAST_BITS bits to (symbol << 4 | length),
+// or 0 if the code is longer than that, in which case `count` and `symbol` are used to decode it
+struct huffman {
+    uint16_t fast[1 << FAST_BITS];
+    uint16_t count[DEFLATE_MAX_CODEWORD_LEN + 1];
+    uint16_t symbol[DEFLATE_NUM_LITLEN_SYMS];
+};
+
+struct gunzip_stream {
+    uint64_t bitbuf;
+    uint32_t bitcnt;
+
+    // pushed input that was not consumed yet
+    uint8_t* in;
+    uint32_t in_pos;
+    uint32_t in_size;
+    uint32_t in_cap;
+
+    uint32_t state;
+    uint32_t flags;
+    uint32_t final_block;
+    uint32_t remaining;
+    uint32_t match_dist;
+
+    uint32_t total_out;
+    uint32_t max_output;
+    uint32_t crc;
+
+    uint32_t num_litlen;
+    uint32_t num_dist;
+    uint32_t num_precode;
+    uint32_t lens_pos;
+    uint8_t lens[DEFLATE_NUM_LITLEN_SYMS + DEFLATE_NUM_OFFSET_SYMS];
+
+    struct huffman precode;
+    struct huffman litlen;
+    struct huffman dist;
+
+    uint8_t window[WINDOW_SIZE];
+};
+
+static const uint8_t precode_order[DEFLATE_NUM_PRECODE_SYMS] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+static const uint16_t length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const uint8_t dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static uint32_t reverse_bits(uint32_t code, uint32_t len) {
+    uint32_t res = 0;
+
+    while (len--) {
+        res = (res << 1) | (code & 1);
+        code >>= 1;
+    }
+
+    return res;
+}
+
+// returns 0 if the code is over-subscribed. incomplete codes are allowed,
+// decoding an unused codeword is reported as an error by `huffman_decode`
+static int huffman_build(struct huffman* h, const uint8_t* lens, uint32_t num_syms) {
+    uint16_t offsets[DEFLATE_MAX_CODEWORD_LEN + 1];
+    uint32_t len, sym, i, code, j;
+    int left = 1;
+
+    memset(h->count, 0, sizeof(h->count));
+    for (sym = 0; sym < num_syms; sym++) h->count[lens[sym]]++;
+    h->count[0] = 0;
+
+    for (len = 1; len <= DEFLATE_MAX_CODEWORD_LEN; len++) {
+        left = (left << 1) - h->count[len];
+        if (left < 0) return 0;
+    }
+
+    offsets[1] = 0;
+    for (len = 1; len < DEFLATE_MAX_CODEWORD_LEN; len++) {
+        offsets[len + 1] = offsets[len] + h->count[len];
+    }
+
+    for (sym = 0; sym < num_syms; sym++) {
+        if (lens[sym] != 0) h->symbol[offsets[lens[sym]]++] = sym;
+    }
+
+    memset(h->fast, 0, sizeof(h->fast));
+
+    code = 0;
+    i = 0;
+    for (len = 1; len <= FAST_BITS; len++) {
+        for (j = 0; j < h->count[len]; j++, i++, code++) {
+            uint32_t entry = (h->symbol[i] << 4) | len;
+            uint32_t k;
+
+            // deflate codes are stored starting from the most significant bit
+            for (k = reverse_bits(code, len); k < (1 << FAST_BITS); k += 1 << len) {
+                h->fast[k] = entry;
+            }
+        }
+        code <<= 1;
+    }
+
+    return 1;
+}
+
+// decode a symbol from the low `avail` bits of `bits`.
+// returns -1 if more bits are needed, -2 if the codeword is not used by the code
+static int huffman_decode(const struct huffman* h, uint64_t bits, uint32_t avail, uint32_t* used) {
+    uint32_t entry = h->fast[bits & FAST_MASK];
+    int code = 0, first = 0, index = 0;
+    uint32_t len;
+
+    if (entry != 0) {
+        if ((entry & 15) > avail) return -1;
+        *used = entry & 15;
+        return entry >> 4;
+    }
+
+    for (len = 1; len <= DEFLATE_MAX_CODEWORD_LEN; len++) {
+        int count;
+
+        if (len > avail) return -1;
+
+        code |= (bits >> (len - 1)) & 1;
+        count = h->count[len];
+        if (code - count < first) {
+            *used = len;
+            return h->symbol[index + (code - first)];
+        }
+
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+
+    return -2;
+}
+
+// move as much pushed input into the bit buffer as fits
+static void fill_bits(struct gunzip_stream* s) {
+    while (s->bitcnt <= 56 && s->in_pos < s->in_size) {
+        s->bitbuf |= (uint64_t) s->in[s->in_pos++] << s->bitcnt;
+        s->bitcnt += 8;
+    }
+}
+
+static void drop_bits(struct gunzip_stream* s, uint32_t n) {
+    s->bitbuf >>= n;
+    s->bitcnt -= n;
+}
+
+static int emit_byte(struct gunzip_stream* s, uint8_t byte, uint8_t* out, uint32_t* out_pos) {
+    if (s->total_out == s->max_output) return 0;
+
+    s->window[s->total_out & WINDOW_MASK] = byte;
+    s->total_out++;
+    out[(*out_pos)++] = byte;
+
+    return 1;
+}
+
+// CRC-32 of the produced output, verified against the trailer. the one-shot path (gzip_decompress.c) is built
+// without libdeflate's crc32 to save code size, here a nibble table is enough since this path is not the hot one
+static const uint32_t crc32_nibble[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+};
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t* data, uint32_t len) {
+    uint32_t i;
+
+    crc = ~crc;
+    for (i = 0; i < len; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ crc32_nibble[crc & 15];
+        crc = (crc >> 4) ^ crc32_nibble[crc & 15];
+    }
+
+    return ~crc;
+}
+
+static void load_static_codes(struct gunzip_stream* s) {
+    uint32_t i;
+
+    for (i = 0; i < 144; i++) s->lens[i] = 8;
+    for (; i < 256; i++) s->lens[i] = 9;
+    for (; i < 280; i++) s->lens[i] = 7;
+    for (; i < DEFLATE_NUM_LITLEN_SYMS; i++) s->lens[i] = 8;
+    huffman_build(&s->litlen, s->lens, DEFLATE_NUM_LITLEN_SYMS);
+
+    for (i = 0; i < DEFLATE_NUM_OFFSET_SYMS; i++) s->lens[i] = 5;
+    huffman_build(&s->dist, s->lens, DEFLATE_NUM_OFFSET_SYMS);
+}
+
+WASM_EXPORT struct gunzip_stream* gunzip_stream_alloc(uint32_t max_output) {
+    struct gunzip_stream* s = (struct gunzip_stream*) __malloc(sizeof(struct gunzip_stream));
+    if (s == NULL) return NULL;
+
+    memset(s, 0, sizeof(struct gunzip_stream));
+    s->max_output = max_output;
+    s->state = ST_HEADER;
+
+    return s;
+}
+
+WASM_EXPORT void gunzip_stream_free(struct gunzip_stream* s) {
+    __free(s->in);
+    __free(s);
+}
+
+// queue more input. the unconsumed part of the previous input is kept, so the buffer
+// only ever grows to the size of the largest chunk plus a few bytes.
+// returns 0, or GUNZIP_ERR_NO_MEMORY if the buffer could not be grown (the stream is left as it was)
+WASM_EXPORT int gunzip_stream_push(struct gunzip_stream* s, const uint8_t* data, uint32_t len) {
+    uint32_t left = s->in_size - s->in_pos;
+
+    if (left + len > s->in_cap) {
+        uint8_t* grown = (uint8_t*) __malloc(left + len);
+        if (grown == NULL) return GUNZIP_ERR_NO_MEMORY;
+
+        if (s->in != NULL) {
+            memcpy(grown, s->in + s->in_pos, left);
+            __free(s->in);
+        }
+        s->in = grown;
+        s->in_cap = left + len;
+    } else if (s->in_pos != 0) {
+        __builtin_memmove(s->in, s->in + s->in_pos, left);
+    }
+
+    memcpy(s->in + left, data, len);
+    s->in_pos = 0;
+    s->in_size = left + len;
+
+    return 0;
+}
+
+WASM_EXPORT uint32_t gunzip_stream_finished(struct gunzip_stream* s) {
+    return s->state == ST_DONE;
+}
+
+// `hashed` is the part of `out` already included in the CRC, the rest is hashed by the caller
+static int gunzip_stream_inflate(struct gunzip_stream* s, uint8_t* out, uint32_t out_len, uint32_t* hashed) {
+    uint32_t out_pos = 0;
+    uint32_t used, i, len;
+    int sym;
+
+#define NEED(n) do { fill_bits(s); if (s->bitcnt < (n)) goto need_input; } while (0)
+#define BITS(n) ((uint32_t) s->bitbuf & ((1u << (n)) - 1))
+#define FAIL(err) do { s->state = ST_ERROR; return (err); } while (0)
+
+    for (;;) {
+        switch (s->state) {
+        case ST_HEADER:
+            NEED(32);
+            if (BITS(8) != GZIP_ID1 || ((s->bitbuf >> 8) & 0xff) != GZIP_ID2) FAIL(GUNZIP_ERR_BAD_DATA);
+            if (((s->bitbuf >> 16) & 0xff) != GZIP_CM_DEFLATE) FAIL(GUNZIP_ERR_BAD_DATA);
+
+            s->flags = (s->bitbuf >> 24) & 0xff;
+            if (s->flags & GZIP_FRESERVED) FAIL(GUNZIP_ERR_BAD_DATA);
+
+            drop_bits(s, 32);
+            s->state = ST_HEADER_REST;
+            break;
+        case ST_HEADER_REST:
+            // MTIME, XFL, OS
+            NEED(48);
+            drop_bits(s, 48);
+            s->state = ST_EXTRA_LEN;
+            break;
+        case ST_EXTRA_LEN:
+            if (s->flags & GZIP_FEXTRA) {
+                NEED(16);
+                s->remaining = BITS(16);
+                drop_bits(s, 16);
+            }
+            s->state = ST_EXTRA;
+            break;
+        case ST_EXTRA:
+            while (s->remaining != 0) {
+                NEED(8);
+                drop_bits(s, 8);
+                s->remaining--;
+            }
+            s->state = ST_NAME;
+            break;
+        case ST_NAME:
+        case ST_COMMENT:
+            if (s->flags & (s->state == ST_NAME ? GZIP_FNAME : GZIP_FCOMMENT)) {
+                for (;;) {
+                    NEED(8);
+                    i = BITS(8);
+                    drop_bits(s, 8);
+                    if (i == 0) break;
+                }
+            }
+            s->state++;
+            break;
+        case ST_HCRC:
+            if (s->flags & GZIP_FHCRC) {
+                NEED(16);
+                drop_bits(s, 16);
+            }
+            s->state = ST_BLOCK_HEADER;
+            break;
+        case ST_BLOCK_HEADER:
+            if (s->final_block) {
+                drop_bits(s, s->bitcnt & 7);
+                s->state = ST_TRAILER;
+                break;
+            }
+
+            NEED(3);
+            s->final_block = BITS(1);
+            i = (s->bitbuf >> 1) & 3;
+            drop_bits(s, 3);
+
+            if (i == DEFLATE_BLOCKTYPE_UNCOMPRESSED) {
+                drop_bits(s, s->bitcnt & 7);
+                s->state = ST_STORED_LEN;
+            } else if (i == DEFLATE_BLOCKTYPE_STATIC_HUFFMAN) {
+                load_static_codes(s);
+                s->state = ST_CODES;
+            } else if (i == DEFLATE_BLOCKTYPE_DYNAMIC_HUFFMAN) {
+                s->state = ST_TABLE_COUNTS;
+            } else {
+                FAIL(GUNZIP_ERR_BAD_DATA);
+            }
+            break;
+        case ST_STORED_LEN:
+            NEED(32);
+            s->remaining = BITS(16);
+            if ((((uint32_t) s->bitbuf >> 16) ^ 0xffff) != s->remaining) FAIL(GUNZIP_ERR_BAD_DATA);
+            drop_bits(s, 32);
+            s->state = ST_STORED;
+            break;
+        case ST_STORED:
+            while (s->remaining != 0) {
+                if (out_pos == out_len) return out_pos;
+                if (s->bitcnt == 0 && s->in_pos == s->in_size) goto need_input;
+
+                // the bit buffer is byte-aligned here, drain it before reading the input directly
+                if (s->bitcnt != 0) {
+                    if (!emit_byte(s, s->bitbuf & 0xff, out, &out_pos)) FAIL(GUNZIP_ERR_TOO_LARGE);
+                    drop_bits(s, 8);
+                    s->remaining--;
+                    continue;
+                }
+
+                len = MIN(MIN(s->remaining, out_len - out_pos), s->in_size - s->in_pos);
+                if (len > s->max_output - s->total_out) FAIL(GUNZIP_ERR_TOO_LARGE);
+
+                for (i = 0; i < len; i++) {
+                    uint8_t byte = s->in[s->in_pos + i];
+                    s->window[(s->total_out + i) & WINDOW_MASK] = byte;
+                    out[out_pos + i] = byte;
+                }
+
+                s->in_pos += len;
+                s->total_out += len;
+                out_pos += len;
+                s->remaining -= len;
+            }
+            s->state = ST_BLOCK_HEADER;
+            break;
+        case ST_TABLE_COUNTS:
+            NEED(14);
+            s->num_litlen = BITS(5) + 257;
+            s->num_dist = ((s->bitbuf >> 5) & 31) + 1;
+            s->num_precode = ((s->bitbuf >> 10) & 15) + 4;
+            drop_bits(s, 14);
+
+            if (s->num_litlen > DEFLATE_NUM_LITLEN_SYMS || s->num_dist > DEFLATE_NUM_OFFSET_SYMS) {
+                FAIL(GUNZIP_ERR_BAD_DATA);
+            }
+
+            memset(s->lens, 0, DEFLATE_NUM_PRECODE_SYMS);
+            s->lens_pos = 0;
+            s->state = ST_PRECODE_LENS;
+            break;
+        case ST_PRECODE_LENS:
+            while (s->lens_pos < s->num_precode) {
+                NEED(3);
+                s->lens[precode_order[s->lens_pos++]] = BITS(3);
+                drop_bits(s, 3);
+            }
+
+            if (!huffman_build(&s->precode, s->lens, DEFLATE_NUM_PRECODE_SYMS)) FAIL(GUNZIP_ERR_BAD_DATA);
+
+            s->lens_pos = 0;
+            s->state = ST_CODE_LENS;
+            break;
+        case ST_CODE_LENS:
+            while (s->lens_pos < s->num_litlen + s->num_dist) {
+                uint32_t extra, repeat, value;
+
+                fill_bits(s);
+                sym = huffman_decode(&s->precode, s->bitbuf, s->bitcnt, &used);
+                if (sym == -1) goto need_input;
+                if (sym < 0) FAIL(GUNZIP_ERR_BAD_DATA);
+
+                if (sym < 16) {
+                    s->lens[s->lens_pos++] = sym;
+                    drop_bits(s, used);
+                    continue;
+                }
+
+                extra = sym == 16 ? 2 : sym == 17 ? 3 : 7;
+                if (s->bitcnt < used + extra) goto need_input;
+
+                repeat = ((uint32_t) (s->bitbuf >> used) & ((1u << extra) - 1)) + (sym == 18 ? 11 : 3);
+                if (sym == 16) {
+                    if (s->lens_pos == 0) FAIL(GUNZIP_ERR_BAD_DATA);
+                    value = s->lens[s->lens_pos - 1];
+                } else {
+                    value = 0;
+                }
+
+                if (s->lens_pos + repeat > s->num_litlen + s->num_dist) FAIL(GUNZIP_ERR_BAD_DATA);
+                while (repeat--) s->lens[s->lens_pos++] = value;
+
+                drop_bits(s, used + extra);
+            }
+
+            // end-of-block must be encodable
+            if (s->lens[DEFLATE_END_OF_BLOCK] == 0) FAIL(GUNZIP_ERR_BAD_DATA);
+            if (!huffman_build(&s->litlen, s->lens, s->num_litlen)) FAIL(GUNZIP_ERR_BAD_DATA);
+            if (!huffman_build(&s->dist, s->lens + s->num_litlen, s->num_dist)) FAIL(GUNZIP_ERR_BAD_DATA);
+
+            s->state = ST_CODES;
+            break;
+        case ST_CODES:
+            for (;;) {
+                uint32_t bits_needed, length, dist;
+                int dsym;
+
+                fill_bits(s);
+                sym = huffman_decode(&s->litlen, s->bitbuf, s->bitcnt, &used);
+                if (sym == -1) goto need_input;
+                if (sym < 0) FAIL(GUNZIP_ERR_BAD_DATA);
+
+                // end of block doesn't produce any output, so it's consumed even if the output is full.
+                // otherwise the trailer would never be reached when the output size is exact
+                if (sym != DEFLATE_END_OF_BLOCK && out_pos == out_len) return out_pos;
+
+                if (sym < 256) {
+                    if (!emit_byte(s, sym, out, &out_pos)) FAIL(GUNZIP_ERR_TOO_LARGE);
+                    drop_bits(s, used);
+                    continue;
+                }
+
+                if (sym == DEFLATE_END_OF_BLOCK) {
+                    drop_bits(s, used);
+                    s->state = ST_BLOCK_HEADER;
+                    break;
+                }
+
+                sym -= 257;
+                if (sym >= 29) FAIL(GUNZIP_ERR_BAD_DATA);
+
+                // length, its extra bits, distance and its extra bits are consumed together.
+                // at most 15 + 5 + 15 + 13 = 48 bits, which always fit into the bit buffer
+                bits_needed = used + length_extra[sym];
+                if (s->bitcnt < bits_needed) goto need_input;
+                length = length_base[sym] + ((uint32_t) (s->bitbuf >> used) & ((1u << length_extra[sym]) - 1));
+
+                dsym = huffman_decode(&s->dist, s->bitbuf >> bits_needed, s->bitcnt - bits_needed, &used);
+                if (dsym == -1) goto need_input;
+                if (dsym < 0 || dsym >= 30) FAIL(GUNZIP_ERR_BAD_DATA);
+
+                bits_needed += used;
+                if (s->bitcnt < bits_needed + dist_extra[dsym]) goto need_input;
+                dist = dist_base[dsym] + ((uint32_t) (s->bitbuf >> bits_needed) & ((1u << dist_extra[dsym]) - 1));
+                bits_needed += dist_extra[dsym];
+
+                if (dist > s->total_out) FAIL(GUNZIP_ERR_BAD_DATA);
+
+                drop_bits(s, bits_needed);
+                s->remaining = length;
+                s->match_dist = dist;
+                s->state = ST_MATCH;
+                break;
+            }
+            break;
+        case ST_MATCH:
+            len = MIN(s->remaining, out_len - out_pos);
+            if (len > s->max_output - s->total_out) FAIL(GUNZIP_ERR_TOO_LARGE);
+
+            for (i = 0; i < len; i++) {
+                uint8_t byte = s->window[(s->total_out - s->match_dist) & WINDOW_MASK];
+                s->window[s->total_out & WINDOW_MASK] = byte;
+                s->total_out++;
+                out[out_pos++] = byte;
+            }
+
+            s->remaining -= len;
+            if (s->remaining != 0) return out_pos;
+
+            s->state = ST_CODES;
+            break;
+        case ST_TRAILER:
+            // CRC32, then ISIZE
+            NEED(64);
+            s->crc = crc32_update(s->crc, out + *hashed, out_pos - *hashed);
+            *hashed = out_pos;
+
+            if ((uint32_t) s->bitbuf != s->crc) FAIL(GUNZIP_ERR_BAD_DATA);
+            if ((uint32_t) (s->bitbuf >> 32) != s->total_out) FAIL(GUNZIP_ERR_BAD_DATA);
+            drop_bits(s, 32);
+            drop_bits(s, 32);
+            s->state = ST_DONE;
+            break;
+        case ST_DONE:
+            return out_pos;
+        default:
+            return GUNZIP_ERR_BAD_DATA;
+        }
+    }
+
+need_input:
+    return out_pos;
+
+#undef NEED
+#undef BITS
+#undef FAIL
+}
+
+/*
+ * Decompress up to `out_len` bytes into `out`.
+ * Returns the number of bytes written (fewer than `out_len` only if more input is needed or the stream
+ * has ended), GUNZIP_ERR_BAD_DATA if the data is invalid (including a CRC32 or ISIZE mismatch in the trailer)
+ * or GUNZIP_ERR_TOO_LARGE if the decompressed data would exceed `max_output`.
+ * Trailing data after the gzip member is ignored.
+ */
+WASM_EXPORT int gunzip_stream_pull(struct gunzip_stream* s, uint8_t* out, uint32_t out_len) {
+    uint32_t hashed = 0;
+    int ret = gunzip_stream_inflate(s, out, out_len, &hashed);
+
+    if (ret > 0) s->crc = crc32_update(s->crc, out + hashed, ret - hashed);
+
+    return ret;
+}
+
+#undef WINDOW_SIZE
+#undef WINDOW_MASK
+#undef FAST_BITS
+#undef FAST_MASK
+#undef GUNZIP_ERR_BAD_DATA
+#undef GUNZIP_ERR_TOO_LARGE
+#undef GUNZIP_ERR_NO_MEMORY
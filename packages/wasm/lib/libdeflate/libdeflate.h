@@ -56,6 +56,11 @@ libdeflate_gzip_compress(struct libdeflate_compressor *compressor,
 			 const void *in, size_t in_nbytes,
 			 void *out, size_t out_nbytes_avail);
 
+LIBDEFLATEAPI size_t
+libdeflate_zlib_compress(struct libdeflate_compressor *compressor,
+			 const void *in, size_t in_nbytes,
+			 void *out, size_t out_nbytes_avail);
+
 //LIBDEFLATEAPI size_t
 //libdeflate_gzip_compress_bound(struct libdeflate_compressor *compressor,
 //			       size_t in_nbytes);
@@ -7,6 +7,10 @@
 
 #include "lib_common.h"
 
+#ifdef __wasm_simd128__
+#  include <wasm_simd128.h>
+#endif
+
 #ifndef MATCHFINDER_WINDOW_ORDER
 #  error "MATCHFINDER_WINDOW_ORDER must be defined!"
 #endif
@@ -152,6 +156,23 @@ lz_extend(const u8 * const strptr, const u8 * const matchptr,
 	unsigned len = start_len;
 	machine_word_t v_word;
 
+#ifdef __wasm_simd128__
+	/*
+	 * Words are only 4 bytes on wasm32, so compare 16 bytes at a time and
+	 * find the first mismatching byte in the comparison bitmask.  The word
+	 * loops below then only handle the last few bytes.
+	 */
+	while (len + 16 <= max_len) {
+		u32 mask = wasm_i8x16_bitmask(wasm_i8x16_eq(
+				wasm_v128_load(&matchptr[len]),
+				wasm_v128_load(&strptr[len])));
+
+		if (mask != 0xFFFF)
+			return len + bsf32(~mask);
+		len += 16;
+	}
+#endif
+
 	if (UNALIGNED_ACCESS_IS_FAST) {
 
 		if (likely(max_len - len >= 4 * WORDBYTES)) {
@@ -29,21 +29,14 @@
 #include "zlib_constants.h"
 #include "adler32.h"
 
-LIBDEFLATEAPI size_t
-libdeflate_zlib_compress(struct libdeflate_compressor *c,
-			 const void *in, size_t in_nbytes,
-			 void *out, size_t out_nbytes_avail)
+/* 2 byte header: CMF and FLG  */
+static u16
+zlib_header(struct libdeflate_compressor *c)
 {
-	u8 *out_next = out;
 	u16 hdr;
 	unsigned compression_level;
 	unsigned level_hint;
-	size_t deflate_size;
-
-	if (out_nbytes_avail <= ZLIB_MIN_OVERHEAD)
-		return 0;
 
-	/* 2 byte header: CMF and FLG  */
 	hdr = (ZLIB_CM_DEFLATE << 8) | (ZLIB_CINFO_32K_WINDOW << 12);
 	compression_level = libdeflate_get_compression_level(c);
 	if (compression_level < 2)
@@ -57,7 +50,21 @@ libdeflate_zlib_compress(struct libdeflate_compressor *c,
 	hdr |= level_hint << 6;
 	hdr |= 31 - (hdr % 31);
 
-	put_unaligned_be16(hdr, out_next);
+	return hdr;
+}
+
+LIBDEFLATEAPI size_t
+libdeflate_zlib_compress(struct libdeflate_compressor *c,
+			 const void *in, size_t in_nbytes,
+			 void *out, size_t out_nbytes_avail)
+{
+	u8 *out_next = out;
+	size_t deflate_size;
+
+	if (out_nbytes_avail <= ZLIB_MIN_OVERHEAD)
+		return 0;
+
+	put_unaligned_be16(zlib_header(c), out_next);
 	out_next += 2;
 
 	/* Compressed data  */
@@ -81,3 +88,166 @@ libdeflate_zlib_compress_bound(struct libdeflate_compressor *c,
 	return ZLIB_MIN_OVERHEAD +
 	       libdeflate_deflate_compress_bound(c, in_nbytes);
 }
+
+/*
+ * Streaming zlib compression.  Input is pushed in chunks of any size and
+ * buffered until a full segment is collected, which is then compressed into
+ * the pending output (see libdeflate_deflate_compress_segment()).  So at most
+ * one segment of input and one segment worth of output are held at a time,
+ * no matter how large the whole stream is.
+ *
+ * The compressor is only used during the push/pull calls, so it can be shared
+ * with other streams and with libdeflate_zlib_compress().
+ */
+
+#define ZLIB_STREAM_SEGMENT_SIZE	(64 * 1024)
+
+/* zlib header and footer, plus the sync flush ending a segment */
+#define ZLIB_STREAM_EXTRA_SIZE		(ZLIB_MIN_OVERHEAD + 6)
+
+struct zlib_stream {
+	struct libdeflate_compressor *c;
+	u32 adler;
+	bool finishing;
+	bool finished;
+
+	u8 *segment;
+	u32 segment_size;
+
+	u8 *pending;
+	u32 pending_pos;
+	u32 pending_size;
+	u32 pending_cap;
+};
+
+LIBDEFLATEAPI void
+zlib_stream_free(struct zlib_stream *s)
+{
+	__free(s->segment);
+	__free(s->pending);
+	__free(s);
+}
+
+LIBDEFLATEAPI struct zlib_stream *
+zlib_stream_alloc(struct libdeflate_compressor *c)
+{
+	struct zlib_stream *s = __malloc(sizeof(*s));
+
+	if (s == NULL)
+		return NULL;
+
+	s->c = c;
+	s->adler = 1;
+	s->finishing = false;
+	s->finished = false;
+	s->segment = __malloc(ZLIB_STREAM_SEGMENT_SIZE);
+	s->segment_size = 0;
+	s->pending_cap = libdeflate_deflate_compress_bound(c,
+				ZLIB_STREAM_SEGMENT_SIZE) + ZLIB_STREAM_EXTRA_SIZE;
+	s->pending = __malloc(s->pending_cap);
+	if (s->segment == NULL || s->pending == NULL) {
+		zlib_stream_free(s);
+		return NULL;
+	}
+	s->pending_pos = 0;
+	s->pending_size = 2;
+	put_unaligned_be16(zlib_header(c), s->pending);
+
+	return s;
+}
+
+/* Compress the buffered segment, if there is room for it in the pending output. */
+static bool
+zlib_stream_flush_segment(struct zlib_stream *s, bool is_final)
+{
+	size_t size;
+
+	if (s->pending_pos == s->pending_size) {
+		s->pending_pos = 0;
+		s->pending_size = 0;
+	}
+	if (s->pending_cap - s->pending_size <
+	    libdeflate_deflate_compress_bound(s->c, s->segment_size) +
+	    ZLIB_STREAM_EXTRA_SIZE)
+		return false;
+
+	size = libdeflate_deflate_compress_segment(s->c, s->segment,
+			s->segment_size, s->pending + s->pending_size,
+			s->pending_cap - s->pending_size, is_final);
+	s->pending_size += size;
+	s->segment_size = 0;
+
+	if (is_final) {
+		put_unaligned_be32(s->adler, s->pending + s->pending_size);
+		s->pending_size += 4;
+		s->finished = true;
+	}
+
+	return true;
+}
+
+/*
+ * Push more input.  Returns the number of bytes consumed, which is less than
+ * 'len' only if the pending output has to be pulled first.
+ */
+LIBDEFLATEAPI u32
+zlib_stream_push(struct zlib_stream *s, const u8 *data, u32 len)
+{
+	u32 consumed = 0;
+
+	while (consumed < len) {
+		u32 n;
+
+		if (s->segment_size == ZLIB_STREAM_SEGMENT_SIZE &&
+		    !zlib_stream_flush_segment(s, false))
+			break;
+
+		n = MIN(len - consumed,
+			ZLIB_STREAM_SEGMENT_SIZE - s->segment_size);
+		__builtin_memcpy(s->segment + s->segment_size,
+				 data + consumed, n);
+		s->adler = libdeflate_adler32(s->adler, data + consumed, n);
+		s->segment_size += n;
+		consumed += n;
+	}
+
+	return consumed;
+}
+
+/* Mark the end of the input.  The rest of the stream is produced by pulling. */
+LIBDEFLATEAPI void
+zlib_stream_finish(struct zlib_stream *s)
+{
+	s->finishing = true;
+}
+
+/*
+ * Pull up to 'out_len' bytes of compressed output.  Returns the number of
+ * bytes written, which is 0 only if more input is needed, or if the stream was
+ * finished and all of it has been pulled.
+ */
+LIBDEFLATEAPI u32
+zlib_stream_pull(struct zlib_stream *s, u8 *out, u32 out_len)
+{
+	u32 written = 0;
+
+	while (written < out_len) {
+		u32 n;
+
+		if (s->pending_pos == s->pending_size) {
+			if (!s->finishing || s->finished)
+				break;
+			zlib_stream_flush_segment(s, true);
+		}
+
+		n = MIN(out_len - written, s->pending_size - s->pending_pos);
+		__builtin_memcpy(out + written, s->pending + s->pending_pos, n);
+		s->pending_pos += n;
+		written += n;
+	}
+
+	return written;
+}
+
+#undef ZLIB_STREAM_SEGMENT_SIZE
+#undef ZLIB_STREAM_EXTRA_SIZE
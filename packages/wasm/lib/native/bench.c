@@ -0,0 +1,264 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Micro-benchmarks for the module's kernels, built for the host (see `make bench`),
+ * so they can be profiled with perf/valgrind without a JS engine in the loop.
+ *
+ * Usage: bench [-t min_ms] [filter...]
+ *
+ * Every benchmark is run on buffers from 16 B to 1 MB. Iterations are doubled until
+ * a run takes at least `min_ms` (default 50), and the best of BENCH_REPEATS runs is reported.
+ * Output is tab-separated, one line per benchmark and size:
+ *
+ *   name  size  iterations  ns_per_op  mb_per_s
+ */
+
+#define BENCH_REPEATS 3
+#define BENCH_MAX_SIZE (1 << 20)
+
+// exports of the module, as seen by the JS side
+extern uint8_t aes_shared_key_buffer[32];
+extern uint8_t aes_shared_iv_buffer[32];
+void ige256_encrypt(uint8_t* in, uint32_t length, uint8_t* out);
+void ige256_decrypt(uint8_t* in, uint32_t length, uint8_t* out);
+struct ctr256_ctx* ctr256_alloc();
+void ctr256_free(struct ctr256_ctx* ctx);
+void ctr256(struct ctr256_ctx* ctx, uint8_t* in, uint32_t length, uint8_t* out);
+void sha1(const uint8_t* data, size_t databytes);
+void sha256(const void* data, uint32_t size);
+
+struct libdeflate_compressor* libdeflate_alloc_compressor(int compression_level);
+void libdeflate_free_compressor(struct libdeflate_compressor* c);
+size_t libdeflate_zlib_compress(struct libdeflate_compressor* c, const void* in, size_t in_nbytes,
+                                void* out, size_t out_nbytes_avail);
+struct libdeflate_decompressor* libdeflate_alloc_decompressor(void);
+void libdeflate_free_decompressor(struct libdeflate_decompressor* d);
+int libdeflate_deflate_decompress(struct libdeflate_decompressor* d, const void* in, size_t in_nbytes,
+                                  void* out, size_t out_nbytes_avail, size_t* actual_out_nbytes_ret);
+
+struct bench_state {
+    uint8_t* in;
+    uint8_t* out;
+    uint32_t size;
+
+    struct ctr256_ctx* ctr;
+    struct libdeflate_compressor* compressor;
+    struct libdeflate_decompressor* decompressor;
+
+    // zlib stream of `in` (level 6), for inflate
+    uint8_t* deflated;
+    size_t deflated_size;
+};
+
+struct bench {
+    const char* name;
+    void (*run)(struct bench_state* s);
+    // compression level for deflate benchmarks, 0 otherwise
+    int level;
+};
+
+static void bench_ige_encrypt(struct bench_state* s) {
+    ige256_encrypt(s->in, s->size, s->out);
+}
+
+static void bench_ige_decrypt(struct bench_state* s) {
+    ige256_decrypt(s->in, s->size, s->out);
+}
+
+static void bench_ctr(struct bench_state* s) {
+    ctr256(s->ctr, s->in, s->size, s->out);
+}
+
+static void bench_sha1(struct bench_state* s) {
+    sha1(s->in, s->size);
+}
+
+static void bench_sha256(struct bench_state* s) {
+    sha256(s->in, s->size);
+}
+
+static void bench_deflate(struct bench_state* s) {
+    if (libdeflate_zlib_compress(s->compressor, s->in, s->size, s->out, 2 * BENCH_MAX_SIZE) == 0) {
+        fprintf(stderr, "deflate failed\n");
+        exit(1);
+    }
+}
+
+static void bench_inflate(struct bench_state* s) {
+    size_t actual;
+
+    // skip the zlib header and the adler32 trailer
+    if (libdeflate_deflate_decompress(s->decompressor, s->deflated + 2, s->deflated_size - 6,
+                                      s->out, s->size, &actual) != 0 || actual != s->size) {
+        fprintf(stderr, "inflate failed\n");
+        exit(1);
+    }
+}
+
+static const struct bench benches[] = {
+    { "ige256-encrypt", bench_ige_encrypt, 0 },
+    { "ige256-decrypt", bench_ige_decrypt, 0 },
+    { "ctr256", bench_ctr, 0 },
+    { "sha1", bench_sha1, 0 },
+    { "sha256", bench_sha256, 0 },
+    { "deflate-1", bench_deflate, 1 },
+    { "deflate-6", bench_deflate, 6 },
+    { "deflate-9", bench_deflate, 9 },
+    { "inflate", bench_inflate, 0 },
+};
+
+static const uint32_t sizes[] = { 16, 64, 256, 1024, 4096, 16384, 65536, 262144, BENCH_MAX_SIZE };
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// text-like data (words picked with xorshift32), so that deflate has something realistic to work with
+static void fill_input(uint8_t* buf, uint32_t size) {
+    static const char* const words[] = {
+        "message", "user", "chat", "id", "peer", "date", "true", "false", "null", "text",
+        "media", "photo", "entities", "reply_to", "flags", "access_hash", "\"", ":", ",", "{", "}",
+    };
+    uint32_t x = 0x12345678;
+    uint32_t pos = 0;
+
+    while (pos < size) {
+        const char* word;
+        uint32_t len;
+
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+
+        if ((x & 3) == 0) {
+            // some numbers, which compress worse
+            buf[pos++] = '0' + (x >> 8) % 10;
+            continue;
+        }
+
+        word = words[(x >> 8) % (sizeof(words) / sizeof(words[0]))];
+        len = strlen(word);
+        if (len > size - pos) len = size - pos;
+
+        memcpy(buf + pos, word, len);
+        pos += len;
+    }
+}
+
+static int matches_filter(const char* name, int argc, char** argv, int first) {
+    int i;
+
+    if (first >= argc) return 1;
+
+    for (i = first; i < argc; i++) {
+        if (strstr(name, argv[i]) != NULL) return 1;
+    }
+
+    return 0;
+}
+
+static void run_bench(const struct bench* b, struct bench_state* s, uint64_t min_ns) {
+    uint64_t best_ns = UINT64_MAX;
+    uint64_t best_iters = 1;
+    uint64_t iters = 1;
+    int repeat;
+
+    // warm-up
+    b->run(s);
+
+    for (repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        for (;;) {
+            uint64_t start = now_ns();
+            uint64_t elapsed, i;
+
+            for (i = 0; i < iters; i++) b->run(s);
+
+            elapsed = now_ns() - start;
+            if (elapsed < min_ns) {
+                iters *= 2;
+                continue;
+            }
+
+            // compare per-op times, since later runs may use more iterations
+            if (elapsed * best_iters < best_ns * iters) {
+                best_ns = elapsed;
+                best_iters = iters;
+            }
+            break;
+        }
+    }
+
+    printf("%s\t%u\t%llu\t%.1f\t%.2f\n", b->name, s->size, (unsigned long long) best_iters,
+           (double) best_ns / best_iters, (double) s->size * best_iters * 1000 / best_ns);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    struct bench_state s;
+    uint64_t min_ns = 50 * 1000000ull;
+    int first = 1;
+    size_t i, j;
+
+    if (argc > 2 && strcmp(argv[1], "-t") == 0) {
+        min_ns = strtoull(argv[2], NULL, 10) * 1000000ull;
+        first = 3;
+    }
+
+    memset(&s, 0, sizeof(s));
+    s.in = malloc(BENCH_MAX_SIZE);
+    s.out = malloc(2 * BENCH_MAX_SIZE);
+    s.deflated = malloc(2 * BENCH_MAX_SIZE);
+    if (!s.in || !s.out || !s.deflated) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    fill_input(s.in, BENCH_MAX_SIZE);
+    for (i = 0; i < 32; i++) {
+        aes_shared_key_buffer[i] = i;
+        aes_shared_iv_buffer[i] = 0xff - i;
+    }
+
+    s.decompressor = libdeflate_alloc_decompressor();
+
+    printf("name\tsize\titerations\tns_per_op\tmb_per_s\n");
+
+    for (i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        const struct bench* b = &benches[i];
+
+        if (!matches_filter(b->name, argc, argv, first)) continue;
+
+        s.compressor = libdeflate_alloc_compressor(b->level ? b->level : 6);
+        s.ctr = ctr256_alloc();
+
+        for (j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++) {
+            s.size = sizes[j];
+
+            if (b->run == bench_inflate) {
+                s.deflated_size = libdeflate_zlib_compress(s.compressor, s.in, s.size,
+                                                           s.deflated, 2 * BENCH_MAX_SIZE);
+            }
+
+            run_bench(b, &s, min_ns);
+        }
+
+        ctr256_free(s.ctr);
+        libdeflate_free_compressor(s.compressor);
+    }
+
+    libdeflate_free_decompressor(s.decompressor);
+    free(s.in);
+    free(s.out);
+    free(s.deflated);
+
+    return 0;
+}
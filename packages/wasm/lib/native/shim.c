@@ -0,0 +1,23 @@
+#include <stdlib.h>
+
+#include "wasm.h"
+
+/*
+ * Replacements for the parts of the module that depend on the wasm runtime
+ * (see utils/allocator.c), so that the sources can be built for the host with libc.
+ */
+
+void* __malloc(size_t size) {
+    void* ptr;
+
+    // same alignment as the wasm allocator gives
+    if (posix_memalign(&ptr, 16, size ? size : 1) != 0) return NULL;
+
+    return ptr;
+}
+
+void __free(void* ptr) {
+    free(ptr);
+}
+
+uint8_t shared_out[256];
@@ -1,8 +1,19 @@
 #include "wasm.h"
 
+/*
+ * General purpose allocator for the module.
+ *
+ * Every block starts with a 16-byte header, and block sizes are multiples of 16,
+ * so all returned pointers are 16-byte aligned (suitable for v128 loads).
+ *
+ * Free blocks are kept in segregated bins: exact-size bins for small blocks,
+ * and power-of-two ranges for large ones. Freed blocks are immediately coalesced
+ * with their free neighbours, and a free block at the end of the heap is returned
+ * to the untouched "top" area, so memory is reused regardless of the order
+ * in which blocks are freed.
+ */
+
 extern unsigned char __heap_base;
-static size_t __heap_tail = (size_t) &__heap_base;
-static size_t __heap_mark = (size_t) &__heap_base;
 
 #define memory_size() __builtin_wasm_memory_size(0)
 
@@ -13,62 +24,289 @@ enum {
 	_mem_flag_free = 0xab34d705
 };
 
+#define BLOCK_ALIGN 16
+#define HEADER_SIZE 16
+// header + two free list pointers
+#define MIN_BLOCK_SIZE ALIGN(HEADER_SIZE + 2 * sizeof(void*), BLOCK_ALIGN)
+
+// blocks smaller than this go to exact-size bins
+#define SMALL_LIMIT 1024
+#define NUM_SMALL_BINS (SMALL_LIMIT / BLOCK_ALIGN)
+// log2(SMALL_LIMIT) .. 31
+#define NUM_LARGE_BINS 22
+
+struct block {
+	// total size of the block, including the header
+	uint32_t size;
+	// size of the previous block in memory (0 for the first block)
+	uint32_t prev_size;
+	uint32_t flag;
+	uint32_t _pad;
+	// only valid in free blocks
+	struct block* next_free;
+	struct block* prev_free;
+};
+
+static size_t __heap_start = 0;
+// end of the area currently split into blocks. everything above it is untouched
+static size_t __heap_top = 0;
+// size of the block right below __heap_top (to set prev_size of new blocks)
+static uint32_t __heap_top_prev_size = 0;
+
+// cheap counters, always enabled. read from JS through __get_allocator_stats
+#define FRAGMENTATION_BUCKETS 8
+
+struct allocator_stats {
+	// sum of sizes of allocated blocks (including headers)
+	uint32_t live_bytes;
+	uint32_t peak_live_bytes;
+	// size of the area split into blocks, used or free
+	uint32_t heap_bytes;
+	uint32_t memory_grow_count;
+	uint32_t malloc_count;
+	uint32_t free_count;
+	// bytes in free blocks below the top, by block size:
+	// <128, <512, <2K, <8K, <32K, <128K, <512K, >=512K
+	uint32_t fragmented_bytes[FRAGMENTATION_BUCKETS];
+};
+
+static struct allocator_stats stats;
+
+static uint32_t fragmentation_bucket(uint32_t size) {
+	uint32_t idx = (31 - __builtin_clz(size) - 5) / 2;
+	return idx < FRAGMENTATION_BUCKETS ? idx : FRAGMENTATION_BUCKETS - 1;
+}
+
+static struct block* small_bins[NUM_SMALL_BINS];
+static struct block* large_bins[NUM_LARGE_BINS];
+static uint64_t small_bins_mask = 0;
+static uint32_t large_bins_mask = 0;
+
+#define BLOCK_AT(addr) ((struct block*) (addr))
+#define BLOCK_PAYLOAD(b) ((void*) ((size_t) (b) + HEADER_SIZE))
+#define BLOCK_NEXT(b) BLOCK_AT((size_t) (b) + (b)->size)
+#define BLOCK_PREV(b) BLOCK_AT((size_t) (b) - (b)->prev_size)
+
+static uint32_t large_bin_index(uint32_t size) {
+	uint32_t idx = 31 - __builtin_clz(size) - 10; // log2(SMALL_LIMIT)
+	return idx < NUM_LARGE_BINS ? idx : NUM_LARGE_BINS - 1;
+}
+
+static void bin_insert(struct block* b) {
+	struct block** head;
+	uint32_t idx;
+
+	if (b->size < SMALL_LIMIT) {
+		idx = b->size / BLOCK_ALIGN;
+		head = &small_bins[idx];
+		small_bins_mask |= (uint64_t) 1 << idx;
+	} else {
+		idx = large_bin_index(b->size);
+		head = &large_bins[idx];
+		large_bins_mask |= (uint32_t) 1 << idx;
+	}
+
+	stats.fragmented_bytes[fragmentation_bucket(b->size)] += b->size;
+
+	b->flag = _mem_flag_free;
+	b->prev_free = NULL;
+	b->next_free = *head;
+	if (*head) (*head)->prev_free = b;
+	*head = b;
+}
+
+static void bin_remove(struct block* b) {
+	uint32_t idx;
+
+	stats.fragmented_bytes[fragmentation_bucket(b->size)] -= b->size;
+
+	if (b->prev_free) {
+		b->prev_free->next_free = b->next_free;
+	} else if (b->size < SMALL_LIMIT) {
+		idx = b->size / BLOCK_ALIGN;
+		small_bins[idx] = b->next_free;
+		if (!b->next_free) small_bins_mask &= ~((uint64_t) 1 << idx);
+	} else {
+		idx = large_bin_index(b->size);
+		large_bins[idx] = b->next_free;
+		if (!b->next_free) large_bins_mask &= ~((uint32_t) 1 << idx);
+	}
+
+	if (b->next_free) b->next_free->prev_free = b->prev_free;
+}
+
+// update prev_size of the block following `b` (or of the top area)
+static void set_next_prev_size(struct block* b) {
+	size_t next = (size_t) b + b->size;
+
+	if (next == __heap_top) {
+		__heap_top_prev_size = b->size;
+	} else {
+		BLOCK_AT(next)->prev_size = b->size;
+	}
+}
+
+// find a free block of at least `size` bytes and remove it from its bin
+static struct block* bin_take(uint32_t size) {
+	struct block* b;
+	uint64_t small;
+	uint32_t large, idx;
+
+	if (size < SMALL_LIMIT) {
+		small = small_bins_mask & ~(((uint64_t) 1 << (size / BLOCK_ALIGN)) - 1);
+		if (small) {
+			b = small_bins[__builtin_ctzll(small)];
+			bin_remove(b);
+			return b;
+		}
+
+		large = large_bins_mask;
+	} else {
+		idx = large_bin_index(size);
+
+		// first fit within the bin that may contain a suitable block
+		for (b = large_bins[idx]; b; b = b->next_free) {
+			if (b->size >= size) {
+				bin_remove(b);
+				return b;
+			}
+		}
+
+		large = large_bins_mask & ~(((uint32_t) 2 << idx) - 1);
+	}
+
+	if (large) {
+		// every block in a higher bin is large enough
+		b = large_bins[__builtin_ctz(large)];
+		bin_remove(b);
+		return b;
+	}
+
+	return NULL;
+}
+
+// carve a new block from the top of the heap, growing memory if needed
+static struct block* top_take(uint32_t size) {
+	size_t total = __heap_top + size;
+	size_t available = memory_size() << 16;
+	struct block* b;
+
+	if (total > available) {
+		if (memory_grow(((total - available) >> 16) + 1) == (size_t) -1) return NULL;
+		stats.memory_grow_count++;
+	}
+
+	b = BLOCK_AT(__heap_top);
+	b->size = size;
+	b->prev_size = __heap_top_prev_size;
+
+	__heap_top = total;
+	__heap_top_prev_size = size;
+	stats.heap_bytes = __heap_top - __heap_start;
+
+	return b;
+}
+
 WASM_EXPORT void* __malloc(size_t n) {
-	n += (8 - (n % 4)) % 4;
-	// check if size is enough
-	size_t total = __heap_tail + n + 3 * sizeof(size_t);
-	size_t size = memory_size() << 16;
-	if (total > size) {
-		memory_grow((total >> 16) - (size >> 16) + 1);
+	struct block* b;
+	struct block* rest;
+	uint32_t size;
+
+	if (__heap_start == 0) {
+		__heap_start = __heap_top = ALIGN((size_t) &__heap_base, BLOCK_ALIGN);
 	}
-	unsigned int r = __heap_tail;
-	*((size_t*) r) = n;
-	r += sizeof(size_t);
-	*((size_t*) r) =_mem_flag_used;
-	r += sizeof(size_t);
-	__heap_tail = r + n;
-	*((size_t*) __heap_tail) = n;
-	__heap_tail += sizeof(size_t);
-	return (void*) r;
+
+	if (n > 0x7fffffff - HEADER_SIZE - BLOCK_ALIGN) return NULL;
+
+	size = ALIGN(n + HEADER_SIZE, BLOCK_ALIGN);
+	if (size < MIN_BLOCK_SIZE) size = MIN_BLOCK_SIZE;
+
+	b = bin_take(size);
+
+	if (b) {
+		// split off the unused part, if it's large enough to be a block
+		if (b->size - size >= MIN_BLOCK_SIZE) {
+			rest = BLOCK_AT((size_t) b + size);
+			rest->size = b->size - size;
+			rest->prev_size = size;
+			b->size = size;
+
+			set_next_prev_size(rest);
+			bin_insert(rest);
+		}
+	} else {
+		b = top_take(size);
+		if (!b) return NULL;
+	}
+
+	b->flag = _mem_flag_used;
+
+	stats.malloc_count++;
+	stats.live_bytes += b->size;
+	if (stats.live_bytes > stats.peak_live_bytes) stats.peak_live_bytes = stats.live_bytes;
+
+	return BLOCK_PAYLOAD(b);
 }
 
 WASM_EXPORT void __free(void* p) {
-	size_t n;
-	// null case
-	if (!p) return;
-	size_t r=(size_t)p;
-	r -= sizeof(size_t);
+	struct block* b;
+	struct block* next;
+	struct block* prev;
+
+	// null case, or pointers that were never returned by __malloc
+	if (!p || ((size_t) p & (BLOCK_ALIGN - 1)) != 0) return;
+	if ((size_t) p < __heap_start + HEADER_SIZE || (size_t) p >= __heap_top) return;
+
+	b = BLOCK_AT((size_t) p - HEADER_SIZE);
+
 	// already free
-	if (*((size_t*) r) != _mem_flag_used) {
-		return;
+	if (b->flag != _mem_flag_used) return;
+
+	stats.free_count++;
+	stats.live_bytes -= b->size;
+
+	// merge with the next block
+	if ((size_t) b + b->size != __heap_top) {
+		next = BLOCK_NEXT(b);
+
+		if (next->flag == _mem_flag_free) {
+			bin_remove(next);
+			next->flag = 0;
+			b->size += next->size;
+		}
 	}
-	// mark it as free
-	size_t flag = _mem_flag_free;
-	*((size_t*) r) = flag;
-	// calc ptr_tail
-	r -= sizeof(size_t);
-	n = *(size_t*) r; // size of current block
-	size_t ptr_tail = ((size_t) p) + n + sizeof(size_t);
-	// if not at tail return without moving __heap_tail
-	if (__heap_tail != ptr_tail) {
-		return;
+
+	// merge with the previous block
+	if (b->prev_size != 0) {
+		prev = BLOCK_PREV(b);
+
+		if (prev->flag == _mem_flag_free) {
+			bin_remove(prev);
+			prev->size += b->size;
+			b->flag = 0;
+			b = prev;
+		}
 	}
-	__heap_tail = r;
-	while (r > (size_t) &__heap_base) {
-		r -= sizeof(size_t);
-		n = *(size_t*) r; // size of previous block
-		r -= n;
-		r -= sizeof(size_t);
-		flag = *((size_t*) r);
-		if (flag != _mem_flag_free) break;
-		r -= sizeof(size_t);
-		n = *(size_t*) r; // size of current block
-		__heap_tail = r;
+
+	if ((size_t) b + b->size == __heap_top) {
+		// give the block back to the top area
+		b->flag = 0;
+		__heap_top = (size_t) b;
+		__heap_top_prev_size = b->prev_size;
+		stats.heap_bytes = __heap_top - __heap_start;
+		return;
 	}
+
+	set_next_prev_size(b);
+	bin_insert(b);
+}
+
+WASM_EXPORT struct allocator_stats* __get_allocator_stats() {
+	return &stats;
 }
 
 uint8_t shared_out[256];
 
 WASM_EXPORT uint8_t* __get_shared_out() {
     return shared_out;
-}
\ No newline at end of file
+}
@@ -5,6 +5,9 @@
 
 #define WASM_EXPORT __attribute__((visibility("default")))
 
+// the module is built with -fno-inline to keep it small, hot helpers have to opt in
+#define WASM_INLINE static inline __attribute__((always_inline))
+
 // see utils/allocator.c
 extern void* __malloc(size_t size);
 extern void __free(void* ptr);
@@ -1,4 +1,4 @@
-import type { MtcuteWasmModule, SyncInitInput } from './types.js'
+import type { DeflateOptions, Int64Like, MtcuteWasmModule, SyncInitInput, WasmStats } from './types.js'
 
 export * from './types.js'
 
@@ -19,7 +19,6 @@ export function getWasmUrl(): URL {
 }
 
 let wasm!: MtcuteWasmModule
-let compressor!: number
 let decompressor!: number
 let sharedOutPtr!: number
 let sharedKeyPtr!: number
@@ -27,7 +26,6 @@ let sharedIvPtr!: number
 let cachedUint8Memory: Uint8Array | null = null
 
 function initCommon() {
-  compressor = wasm.libdeflate_alloc_compressor(6)
   decompressor = wasm.libdeflate_alloc_decompressor()
   sharedOutPtr = wasm.__get_shared_out()
   sharedKeyPtr = wasm.__get_shared_key_buffer()
@@ -64,188 +62,1322 @@ export function initSync(module: SyncInitInput): void {
 
 /* c8 ignore end */
 
+// reusable area for copying data in and out of WASM memory, to avoid allocating on every call
+let scratchPtr = 0
+let scratchSize = 0
+// area handed out to the user by `getStagingBuffers`
+let stagingPtr = 0
+let stagingSize = 0
+
+// location and length of the input and location of the output of the current call, set by `stage`
+let stagedIn = 0
+let stagedLength = 0
+let stagedOut = 0
+let stagedOutCopy = false
+const sliceOffsets: number[] = []
+const sliceLengths: number[] = []
+const EMPTY = new Uint8Array(0)
+
+// scratch areas larger than this are released once the current task is done,
+// so that a single large call doesn't pin that much of the heap for good
+const SCRATCH_KEEP_SIZE = 1024 * 1024
+
+function malloc(size: number): number {
+  const ptr = wasm.__malloc(size)
+  if (ptr === 0) throw new RangeError(`failed to allocate ${size} bytes of WASM memory`)
+
+  return ptr
+}
+
+function releaseScratch(): void {
+  wasm.__free(scratchPtr)
+  scratchPtr = 0
+  scratchSize = 0
+}
+
+function trimScratch(): void {
+  if (scratchSize > SCRATCH_KEEP_SIZE) releaseScratch()
+}
+
+function ensureScratch(size: number): number {
+  if (size > scratchSize) {
+    const newSize = Math.max(size, scratchSize * 2)
+
+    releaseScratch()
+    scratchPtr = malloc(newSize)
+    scratchSize = newSize
+
+    if (newSize > SCRATCH_KEEP_SIZE) queueMicrotask(trimScratch)
+  }
+
+  return scratchPtr
+}
+
+/**
+ * Make `data` and `outSize` bytes of output available in WASM memory.
+ * Buffers that already are views of WASM memory are used in place,
+ * everything else goes through the scratch area.
+ *
+ * `inPlace` should be set for functions that support `out == in`: then the output
+ * is written over the input when `out` is `data`, or when both have to be copied anyway
+ */
+function stage(data: Uint8Array, out: Uint8Array | null, outSize: number, inPlace = false): void {
+  const buffer = wasm.memory.buffer
+  const inWasm = data.buffer === buffer
+  const outWasm = out !== null && out.buffer === buffer
+  const overwrite = inPlace && (out === data || (!inWasm && !outWasm))
+  const inSize = inWasm ? 0 : (data.length + 15) & ~15
+  const needed = inSize + (outWasm || overwrite ? 0 : outSize)
+
+  // offsets must be read before growing the scratch area, since growing the memory detaches the views
+  stagedIn = data.byteOffset
+  stagedLength = data.length
+  stagedOut = outWasm ? out.byteOffset : 0
+  stagedOutCopy = !outWasm
+
+  if (needed === 0) return
+
+  ensureScratch(needed)
+
+  if (!inWasm) {
+    getUint8Memory().set(data, scratchPtr)
+    stagedIn = scratchPtr
+  }
+
+  if (overwrite) {
+    stagedOut = stagedIn
+  } else if (!outWasm) {
+    stagedOut = scratchPtr + inSize
+  }
+}
+
+/** Copy the result of the current call from WASM memory to `out`, unless it was written there directly */
+function unstage(out: Uint8Array, from: number, length: number): void {
+  if (stagedOutCopy) {
+    out.set(getUint8Memory().subarray(from, from + length))
+  } else if (from !== stagedOut) {
+    getUint8Memory().copyWithin(stagedOut, from, from + length)
+  }
+}
+
+function concatChunks(chunks: Uint8Array[], total: number): Uint8Array {
+  if (chunks.length === 1) return chunks[0]
+
+  const out = new Uint8Array(total)
+  let offset = 0
+
+  for (const chunk of chunks) {
+    out.set(chunk, offset)
+    offset += chunk.length
+  }
+
+  return out
+}
+
+function checkOutput(out: Uint8Array, length: number): void {
+  if (out.length < length) throw new RangeError(`output buffer is too small (${out.length} < ${length})`)
+}
+
+/**
+ * Get views of a reusable staging area inside WASM memory, to avoid copying data in and out of it.
+ *
+ * When `input` and `output` are passed to a `*Into` function, it reads and writes them in place.
+ *
+ * > **Note**: the area is shared, so the views are only valid until the next call to this function.
+ * > They are also detached if the WASM memory grows, which can happen in any function
+ * > that has to copy data into WASM memory, so it's best to call this right before using them
+ */
+export function getStagingBuffers(inputSize: number, outputSize: number): [input: Uint8Array, output: Uint8Array] {
+  const inSize = (inputSize + 15) & ~15
+  const needed = inSize + outputSize
+
+  if (needed > stagingSize) {
+    const newSize = Math.max(needed, stagingSize * 2)
+
+    wasm.__free(stagingPtr)
+    stagingPtr = 0
+    stagingSize = 0
+
+    stagingPtr = malloc(newSize)
+    stagingSize = newSize
+  }
+
+  const mem = getUint8Memory()
+
+  return [
+    mem.subarray(stagingPtr, stagingPtr + inputSize),
+    mem.subarray(stagingPtr + inSize, stagingPtr + inSize + outputSize),
+  ]
+}
+
+// compressors by level, allocated on first use since each one takes 100s of KB
+const compressors = new Map<number, number>()
+
+// inputs smaller than this are compressed at level 1: matchfinder setup dominates, and level 6 is barely better.
+// inputs of at least DEFLATE_BEST_MIN are compressed at level 9 (~3x slower than 6 for ~3% smaller output)
+const DEFLATE_FAST_MAX = 2048
+const DEFLATE_BEST_MIN = 256 * 1024
+
+function getCompressor(level: number): number {
+  let ptr = compressors.get(level)
+  if (ptr === undefined) {
+    ptr = wasm.libdeflate_alloc_compressor(level)
+    if (ptr === 0) throw new RangeError(`Invalid compression level: ${level}`)
+
+    compressors.set(level, ptr)
+  }
+
+  return ptr
+}
+
+function deflateLevel(inputSize: number, options?: DeflateOptions): number {
+  if (options?.level !== undefined) return options.level
+  if (inputSize < DEFLATE_FAST_MAX) return 1
+  if (inputSize >= DEFLATE_BEST_MIN) return 9
+
+  return 6
+}
+
+/**
+ * Deflate some data with zlib headers and max output size, writing the result to `out`
+ * (at most `out.length` bytes)
+ *
+ * @returns number of bytes written, or 0 if the compressed data is larger than `out`
+ */
+export function deflateMaxSizeInto(bytes: Uint8Array, out: Uint8Array, options?: DeflateOptions): number {
+  const size = out.length
+  const compressor = getCompressor(deflateLevel(bytes.length, options))
+  stage(bytes, out, size)
+
+  const written = wasm.libdeflate_zlib_compress(compressor, stagedIn, stagedLength, stagedOut, size)
+  if (written !== 0) unstage(out, stagedOut, written)
+
+  return written
+}
+
+/**
+ * Deflate some data with zlib headers and max output size
+ *
+ * @returns null if the compressed data is larger than `size`, otherwise the compressed data
+ */
+export function deflateMaxSize(bytes: Uint8Array, size: number, options?: DeflateOptions): Uint8Array | null {
+  const compressor = getCompressor(deflateLevel(bytes.length, options))
+  stage(bytes, null, size)
+
+  const written = wasm.libdeflate_zlib_compress(compressor, stagedIn, stagedLength, stagedOut, size)
+  if (written === 0) return null
+
+  return getUint8Memory().slice(stagedOut, stagedOut + written)
+}
+
+/**
+ * Compress some data and serialize it as a `gzip_packed` TL object (constructor ID, bytes length,
+ * zlib stream and padding), writing the result to `out` (at most `out.length` bytes)
+ *
+ * @returns number of bytes written, or 0 if the object is larger than `out`
+ */
+export function gzipPackedInto(bytes: Uint8Array, out: Uint8Array, options?: DeflateOptions): number {
+  const size = out.length
+  const compressor = getCompressor(deflateLevel(bytes.length, options))
+  stage(bytes, out, size)
+
+  const written = wasm.gzip_packed_compress(compressor, stagedIn, stagedLength, stagedOut, size)
+  if (written !== 0) unstage(out, stagedOut, written)
+
+  return written
+}
+
+/**
+ * Compress some data and serialize it as a `gzip_packed` TL object
+ *
+ * @returns null if the object is larger than `size`, otherwise the serialized object
+ */
+export function gzipPacked(bytes: Uint8Array, size: number, options?: DeflateOptions): Uint8Array | null {
+  const compressor = getCompressor(deflateLevel(bytes.length, options))
+  stage(bytes, null, size)
+
+  const written = wasm.gzip_packed_compress(compressor, stagedIn, stagedLength, stagedOut, size)
+  if (written === 0) return null
+
+  return getUint8Memory().slice(stagedOut, stagedOut + written)
+}
+
+// size of the segments the streaming compressor works with, see zlib_compress.c
+const DEFLATE_SEGMENT_SIZE = 65536
+
+function allocDeflate(level: number): number {
+  const ctx = wasm.zlib_stream_alloc(getCompressor(level))
+  if (ctx === 0) throw new RangeError('failed to allocate a deflate context')
+
+  return ctx
+}
+
+/**
+ * Create a streaming zlib compressor (at level 6 unless specified otherwise).
+ * Input is fed with {@link deflatePush} and output is read with {@link deflatePullInto},
+ * so only about a segment (64 KB) of input and output is kept in WASM memory at a time.
+ *
+ * Segments are compressed independently, so the output is slightly larger than with {@link deflateMaxSize}
+ *
+ * > **Note**: `freeDeflate` must be called on the returned context when it's no longer needed
+ */
+export function createDeflate(options?: DeflateOptions): number {
+  return allocDeflate(options?.level ?? 6)
+}
+
+/**
+ * Release a context created by `createDeflate`
+ */
+export function freeDeflate(ctx: number): void {
+  wasm.zlib_stream_free(ctx)
+}
+
+/**
+ * Feed more data to a streaming compressor
+ *
+ * @param ctx  context returned by `createDeflate`
+ * @returns  number of bytes consumed. if less than `data.length`, the output has to be pulled
+ *   with {@link deflatePullInto} before pushing the rest
+ */
+export function deflatePush(ctx: number, data: Uint8Array): number {
+  stage(data, null, 0)
+
+  return wasm.zlib_stream_push(ctx, stagedIn, stagedLength)
+}
+
+/**
+ * Mark the end of the input of a streaming compressor. The rest of the output can then be pulled
+ *
+ * @param ctx  context returned by `createDeflate`
+ */
+export function deflateFinish(ctx: number): void {
+  wasm.zlib_stream_finish(ctx)
+}
+
+/**
+ * Read the compressed data produced so far into `out`
+ *
+ * @param ctx  context returned by `createDeflate`
+ * @returns  number of bytes written. 0 means that more input is needed, or that the stream
+ *   was finished and all of it has been read
+ */
+export function deflatePullInto(ctx: number, out: Uint8Array): number {
+  stage(EMPTY, out, out.length)
+
+  const written = wasm.zlib_stream_pull(ctx, stagedOut, out.length)
+  unstage(out, stagedOut, written)
+
+  return written
+}
+
+/**
+ * Deflate the concatenation of `chunks` with zlib headers and max output size,
+ * without copying all of it into WASM memory at once
+ *
+ * @returns null if the compressed data is larger than `size`, otherwise the compressed data
+ */
+export function deflateChunksMaxSize(
+  chunks: Uint8Array[],
+  size: number,
+  options?: DeflateOptions,
+): Uint8Array | null {
+  let inputSize = 0
+  for (const chunk of chunks) inputSize += chunk.length
+
+  const ctx = allocDeflate(deflateLevel(inputSize, options))
+  const out: Uint8Array[] = []
+  let total = 0
+
+  const pull = () => {
+    stage(EMPTY, null, DEFLATE_SEGMENT_SIZE)
+
+    const written = wasm.zlib_stream_pull(ctx, stagedOut, DEFLATE_SEGMENT_SIZE)
+    if (written !== 0) {
+      out.push(getUint8Memory().slice(stagedOut, stagedOut + written))
+      total += written
+    }
+
+    return written
+  }
+
+  try {
+    for (const chunk of chunks) {
+      let pos = 0
+
+      while (pos < chunk.length) {
+        stage(chunk.subarray(pos, pos + DEFLATE_SEGMENT_SIZE), null, 0)
+        pos += wasm.zlib_stream_push(ctx, stagedIn, stagedLength)
+
+        pull()
+        if (total > size) return null
+      }
+    }
+
+    wasm.zlib_stream_finish(ctx)
+
+    while (pull() !== 0) {
+      if (total > size) return null
+    }
+  } finally {
+    wasm.zlib_stream_free(ctx)
+  }
+
+  return concatChunks(out, total)
+}
+
+/**
+ * Estimate how well some data would deflate, without actually compressing it.
+ * Only a sample from the middle of the data (at most 8 KB) is looked at
+ *
+ * @returns  estimated ratio of compressed to original size, between 0 and 1
+ */
+export function estimateCompressibility(bytes: Uint8Array): number {
+  stage(bytes, null, 0)
+
+  return wasm.estimate_compressibility(stagedIn, stagedLength) / 1024
+}
+
+/**
+ * Get the size of the decompressed data, as declared in the gzip trailer
+ */
+export function gunzipOutputSize(bytes: Uint8Array): number {
+  const len = bytes.length
+
+  return (bytes[len - 4] | (bytes[len - 3] << 8) | (bytes[len - 2] << 16) | (bytes[len - 1] << 24)) >>> 0
+}
+
+/**
+ * Try to decompress some gzipped data into `out`
+ *
+ * @throws  Error if the data is invalid, RangeError if `out` is smaller than {@link gunzipOutputSize}
+ * @returns  number of bytes written
+ */
+export function gunzipInto(bytes: Uint8Array, out: Uint8Array): number {
+  const size = gunzipOutputSize(bytes)
+  checkOutput(out, size)
+
+  stage(bytes, out, size)
+
+  const ret = wasm.libdeflate_gzip_decompress(decompressor, stagedIn, stagedLength, stagedOut, size)
+
+  /* c8 ignore next 3 */
+  if (ret === 1) throw new Error('gunzip error -- bad data')
+  if (ret === 2) throw new Error('gunzip error -- short output')
+  if (ret === 3) throw new Error('gunzip error -- short input') // should never happen
+
+  unstage(out, stagedOut, size)
+
+  return size
+}
+
+// the output buffer is allocated with the size declared in the gzip trailer, which can't be trusted.
+// data declaring more than this is decompressed in chunks instead, so a bogus trailer can't grow WASM memory unboundedly
+const GUNZIP_ONESHOT_LIMIT = 16 * 1024 * 1024
+
+/**
+ * Try to decompress some gzipped data.
+ *
+ * The data is decompressed by libdeflate in one go. If the gzip trailer declares an output
+ * larger than 16 MB, it is decompressed in chunks instead (see {@link gunzipChunked}).
+ * Use {@link createGunzip} directly to decompress in bounded chunks regardless of the size
+ *
+ * @throws  Error if the data is invalid
+ */
+export function gunzip(bytes: Uint8Array): Uint8Array {
+  const size = gunzipOutputSize(bytes)
+  if (size > GUNZIP_ONESHOT_LIMIT) return gunzipChunked(bytes)
+
+  const out = new Uint8Array(size)
+  gunzipInto(bytes, out)
+
+  return out
+}
+
+/**
+ * Create a streaming gunzip context. Input is fed with {@link gunzipPush}
+ * and output is read with {@link gunzipPullInto} in chunks of any size
+ *
+ * > **Note**: `freeGunzip` must be called on the returned context when it's no longer needed
+ *
+ * @param maxOutput  maximum total size of the decompressed data, larger outputs are rejected
+ */
+export function createGunzip(maxOutput = 0xFFFFFFFF): number {
+  const ctx = wasm.gunzip_stream_alloc(maxOutput)
+  if (ctx === 0) throw new RangeError('failed to allocate a gunzip context')
+
+  return ctx
+}
+
+/**
+ * Release a context created by `createGunzip`
+ */
+export function freeGunzip(ctx: number): void {
+  wasm.gunzip_stream_free(ctx)
+}
+
+/**
+ * Feed more compressed data to a streaming gunzip context.
+ * The data is copied, so the buffer can be reused right away
+ *
+ * @param ctx  context returned by `createGunzip`
+ * @param data  next chunk of the gzipped data
+ */
+export function gunzipPush(ctx: number, data: Uint8Array): void {
+  stage(data, null, 0)
+  checkGunzipResult(wasm.gunzip_stream_push(ctx, stagedIn, stagedLength))
+}
+
+function checkGunzipResult(ret: number): void {
+  if (ret === -1) throw new Error('gunzip error -- bad data')
+  if (ret === -2) throw new RangeError('gunzip error -- output is too large')
+  if (ret === -3) throw new RangeError('failed to allocate WASM memory for gunzip input')
+}
+
+/**
+ * Decompress as much of the pushed data as possible into `out`.
+ *
+ * If less than `out.length` bytes were written, either more input is needed
+ * or the stream has ended (see {@link gunzipFinished})
+ *
+ * @param ctx  context returned by `createGunzip`
+ * @throws  Error if the data is invalid, RangeError if the output exceeds `maxOutput`
+ * @returns  number of bytes written
+ */
+export function gunzipPullInto(ctx: number, out: Uint8Array): number {
+  stage(EMPTY, out, out.length)
+
+  const ret = wasm.gunzip_stream_pull(ctx, stagedOut, out.length)
+  checkGunzipResult(ret)
+  unstage(out, stagedOut, ret)
+
+  return ret
+}
+
+/**
+ * Check whether the whole gzip stream was decompressed
+ *
+ * @param ctx  context returned by `createGunzip`
+ */
+export function gunzipFinished(ctx: number): boolean {
+  return wasm.gunzip_stream_finished(ctx) !== 0
+}
+
+/**
+ * Decompress some gzipped data in chunks of `chunkSize` bytes, ignoring the size declared in the gzip trailer.
+ * Only one chunk of input and output is kept in WASM memory at a time
+ *
+ * @param maxOutput  maximum size of the decompressed data
+ * @param chunkSize  size of the input and output chunks
+ * @throws  Error if the data is invalid, RangeError if the output exceeds `maxOutput`
+ */
+export function gunzipChunked(bytes: Uint8Array, maxOutput = 0xFFFFFFFF, chunkSize = 65536): Uint8Array {
+  const ctx = createGunzip(maxOutput)
+  const chunks: Uint8Array[] = []
+  let total = 0
+  let pos = 0
+
+  try {
+    for (;;) {
+      stage(EMPTY, null, chunkSize)
+
+      const ret = wasm.gunzip_stream_pull(ctx, stagedOut, chunkSize)
+      checkGunzipResult(ret)
+
+      if (ret !== 0) {
+        chunks.push(getUint8Memory().slice(stagedOut, stagedOut + ret))
+        total += ret
+      }
+
+      if (wasm.gunzip_stream_finished(ctx)) break
+      if (ret === chunkSize) continue
+
+      if (pos >= bytes.length) throw new Error('gunzip error -- short input')
+
+      gunzipPush(ctx, bytes.subarray(pos, pos + chunkSize))
+      pos += chunkSize
+    }
+  } finally {
+    wasm.gunzip_stream_free(ctx)
+  }
+
+  return concatChunks(chunks, total)
+}
+
+function ige256Into(
+  fn: (data: number, dataLen: number, out: number) => void,
+  data: Uint8Array,
+  key: Uint8Array,
+  iv: Uint8Array,
+  out: Uint8Array,
+): void {
+  checkOutput(out, data.length)
+  stage(data, out, data.length, true)
+
+  const mem = getUint8Memory()
+  mem.set(key, sharedKeyPtr)
+  mem.set(iv, sharedIvPtr)
+
+  fn(stagedIn, stagedLength, stagedOut)
+  unstage(out, stagedOut, stagedLength)
+}
+
+/**
+ * Pefrorm AES-IGE-256 encryption, writing the result to `out`
+ *
+ * @param data  data to encrypt (must be a multiple of 16 bytes)
+ * @param key  encryption key (32 bytes)
+ * @param iv  initialization vector (32 bytes)
+ * @param out  output buffer (at least `data.length` bytes). May be `data` itself to encrypt in place
+ */
+export function ige256EncryptInto(data: Uint8Array, key: Uint8Array, iv: Uint8Array, out: Uint8Array): void {
+  ige256Into(wasm.ige256_encrypt, data, key, iv, out)
+}
+
+/**
+ * Pefrorm AES-IGE-256 encryption
+ *
+ * @param data  data to encrypt (must be a multiple of 16 bytes)
+ * @param key  encryption key (32 bytes)
+ * @param iv  initialization vector (32 bytes)
+ */
+export function ige256Encrypt(data: Uint8Array, key: Uint8Array, iv: Uint8Array): Uint8Array {
+  const out = new Uint8Array(data.length)
+  ige256Into(wasm.ige256_encrypt, data, key, iv, out)
+
+  return out
+}
+
+/**
+ * Pefrorm AES-IGE-256 encryption in place, overwriting `data`
+ *
+ * @param data  data to encrypt (must be a multiple of 16 bytes)
+ * @param key  encryption key (32 bytes)
+ * @param iv  initialization vector (32 bytes)
+ */
+export function ige256EncryptInPlace(data: Uint8Array, key: Uint8Array, iv: Uint8Array): void {
+  ige256Into(wasm.ige256_encrypt, data, key, iv, data)
+}
+
+/**
+ * Pefrorm AES-IGE-256 decryption, writing the result to `out`
+ *
+ * @param data  data to decrypt (must be a multiple of 16 bytes)
+ * @param key  encryption key (32 bytes)
+ * @param iv  initialization vector (32 bytes)
+ * @param out  output buffer (at least `data.length` bytes). May be `data` itself to decrypt in place
+ */
+export function ige256DecryptInto(data: Uint8Array, key: Uint8Array, iv: Uint8Array, out: Uint8Array): void {
+  ige256Into(wasm.ige256_decrypt, data, key, iv, out)
+}
+
+/**
+ * Pefrorm AES-IGE-256 decryption
+ *
+ * @param data  data to decrypt (must be a multiple of 16 bytes)
+ * @param key  encryption key (32 bytes)
+ * @param iv  initialization vector (32 bytes)
+ */
+export function ige256Decrypt(data: Uint8Array, key: Uint8Array, iv: Uint8Array): Uint8Array {
+  const out = new Uint8Array(data.length)
+  ige256Into(wasm.ige256_decrypt, data, key, iv, out)
+
+  return out
+}
+
+/**
+ * Pefrorm AES-IGE-256 decryption in place, overwriting `data`
+ *
+ * @param data  data to decrypt (must be a multiple of 16 bytes)
+ * @param key  encryption key (32 bytes)
+ * @param iv  initialization vector (32 bytes)
+ */
+export function ige256DecryptInPlace(data: Uint8Array, key: Uint8Array, iv: Uint8Array): void {
+  ige256Into(wasm.ige256_decrypt, data, key, iv, data)
+}
+
+/**
+ * Create a context for AES-CTR-256 en/decryption
+ *
+ * > **Note**: `freeCtr256` must be called on the returned context when it's no longer needed
+ */
+export function createCtr256(key: Uint8Array, iv: Uint8Array): number {
+  getUint8Memory().set(key, sharedKeyPtr)
+  getUint8Memory().set(iv, sharedIvPtr)
+
+  return wasm.ctr256_alloc()
+}
+
+/**
+ * Release a context for AES-CTR-256 en/decryption
+ */
+export function freeCtr256(ctx: number): void {
+  wasm.ctr256_free(ctx)
+}
+
+/**
+ * Pefrorm AES-CTR-256 en/decryption, writing the result to `out`
+ *
+ * @param ctx  context returned by `createCtr256`
+ * @param data  data to en/decrypt
+ * @param out  output buffer (at least `data.length` bytes). May be `data` itself to en/decrypt in place
+ */
+export function ctr256Into(ctx: number, data: Uint8Array, out: Uint8Array): void {
+  checkOutput(out, data.length)
+  stage(data, out, data.length, true)
+
+  wasm.ctr256(ctx, stagedIn, stagedLength, stagedOut)
+  unstage(out, stagedOut, stagedLength)
+}
+
+/**
+ * Pefrorm AES-CTR-256 en/decryption in place, overwriting `data`
+ *
+ * @param ctx  context returned by `createCtr256`
+ * @param data  data to en/decrypt
+ */
+export function ctr256InPlace(ctx: number, data: Uint8Array): void {
+  ctr256Into(ctx, data, data)
+}
+
 /**
- * Deflate some data with zlib headers and max output size
+ * Pefrorm AES-CTR-256 en/decryption
  *
- * @returns null if the compressed data is larger than `size`, otherwise the compressed data
+ * @param ctx  context returned by `createCtr256`
+ * @param data  data to en/decrypt
+ */
+export function ctr256(ctx: number, data: Uint8Array): Uint8Array {
+  const out = new Uint8Array(data.length)
+  ctr256Into(ctx, data, out)
+
+  return out
+}
+
+/**
+ * Calculate a SHA-256 hash, writing it to `out`
+ *
+ * @param data  data to hash
+ * @param out  output buffer (at least 32 bytes)
  */
-export function deflateMaxSize(bytes: Uint8Array, size: number): Uint8Array | null {
-  const outputPtr = wasm.__malloc(size)
-  const inputPtr = wasm.__malloc(bytes.length)
+export function sha256Into(data: Uint8Array, out: Uint8Array): void {
+  checkOutput(out, 32)
+  stage(data, out, 0)
+
+  wasm.sha256(stagedIn, stagedLength)
+  unstage(out, sharedOutPtr, 32)
+}
+
+/**
+ * Calculate a SHA-256 hash
+ *
+ * @param data  data to hash
+ */
+export function sha256(data: Uint8Array): Uint8Array {
+  stage(data, null, 0)
+  wasm.sha256(stagedIn, stagedLength)
+
+  return getUint8Memory().slice(sharedOutPtr, sharedOutPtr + 32)
+}
+
+/**
+ * Write a table of (ptr, len) pairs describing `slices` to the scratch area,
+ * followed by copies of the slices that aren't in WASM memory yet, and `outSize` bytes
+ * for the output (its address is stored in `stagedOut`)
+ *
+ * @returns  address of the table
+ */
+function stageSlices(slices: Uint8Array[], outSize: number): number {
+  const buffer = wasm.memory.buffer
+  const count = slices.length
+
+  // offsets and lengths must be read before growing the scratch area (see `stage`),
+  // offset -1 means the slice has to be copied
+  let size = count * 8
+  for (let i = 0; i < count; i++) {
+    const slice = slices[i]
+    sliceLengths[i] = slice.length
 
+    if (slice.buffer === buffer) {
+      sliceOffsets[i] = slice.byteOffset
+    } else {
+      sliceOffsets[i] = -1
+      size += (slice.length + 15) & ~15
+    }
+  }
+
+  const base = ensureScratch(size + outSize)
   const mem = getUint8Memory()
-  mem.set(bytes, inputPtr)
 
-  const written = wasm.libdeflate_zlib_compress(compressor, inputPtr, bytes.length, outputPtr, size)
-  wasm.__free(inputPtr)
+  let pos = base + count * 8
+  for (let i = 0; i < count; i++) {
+    const slice = slices[i]
+    let ptr = sliceOffsets[i]
 
-  if (written === 0) {
-    wasm.__free(outputPtr)
+    if (ptr === -1) {
+      mem.set(slice, pos)
+      ptr = pos
+      pos += (slice.length + 15) & ~15
+    }
 
-    return null
+    writeInt32(mem, base + i * 8, ptr)
+    writeInt32(mem, base + i * 8 + 4, sliceLengths[i])
   }
 
-  const result = mem.slice(outputPtr, outputPtr + written)
-  wasm.__free(outputPtr)
+  stagedOut = base + size
 
-  return result
+  return base
 }
 
 /**
- * Try to decompress some data with zlib headers
+ * Calculate SHA-256 hash of the concatenation of `slices`, without concatenating them in JS
  *
- * @throws  Error if the data is invalid
- * @param defaultCapacity  default capacity of the output buffer. Defaults to `bytes.length * 2`
+ * @param slices  data to hash
  */
-export function gunzip(bytes: Uint8Array): Uint8Array {
-  const inputPtr = wasm.__malloc(bytes.length)
-  getUint8Memory().set(bytes, inputPtr)
+export function sha256v(slices: Uint8Array[]): Uint8Array {
+  wasm.sha256_iov(stageSlices(slices, 0), slices.length, sharedOutPtr)
+
+  return getUint8Memory().slice(sharedOutPtr, sharedOutPtr + 32)
+}
 
-  const size = wasm.libdeflate_gzip_get_output_size(inputPtr, bytes.length)
-  const outputPtr = wasm.__malloc(size)
+/**
+ * Calculate SHA-1 hash of the concatenation of `slices`, without concatenating them in JS
+ *
+ * @param slices  data to hash
+ */
+export function sha1v(slices: Uint8Array[]): Uint8Array {
+  wasm.sha1_iov(stageSlices(slices, 0), slices.length, sharedOutPtr)
 
-  const ret = wasm.libdeflate_gzip_decompress(decompressor, inputPtr, bytes.length, outputPtr, size)
+  return getUint8Memory().slice(sharedOutPtr, sharedOutPtr + 20)
+}
 
-  /* c8 ignore next 3 */
-  if (ret === -1) throw new Error('gunzip error -- bad data')
-  if (ret === -2) throw new Error('gunzip error -- short output')
-  if (ret === -3) throw new Error('gunzip error -- short input') // should never happen
+/**
+ * Calculate SHA-256 hashes of multiple independent inputs, writing the digests
+ * one after another to `out`. In the SIMD build, up to 4 inputs are hashed at once
+ *
+ * @param inputs  data to hash
+ * @param out  output buffer (at least `inputs.length * 32` bytes)
+ */
+export function sha256BatchInto(inputs: Uint8Array[], out: Uint8Array): void {
+  checkOutput(out, inputs.length * 32)
+
+  const outWasm = out.buffer === wasm.memory.buffer
+  const outOffset = out.byteOffset
+  const table = stageSlices(inputs, outWasm ? 0 : inputs.length * 32)
+
+  if (outWasm) {
+    wasm.sha256_multi(table, inputs.length, outOffset)
+  } else {
+    wasm.sha256_multi(table, inputs.length, stagedOut)
+    out.set(getUint8Memory().subarray(stagedOut, stagedOut + inputs.length * 32))
+  }
+}
+
+/**
+ * Calculate SHA-256 hashes of multiple independent inputs.
+ * In the SIMD build, up to 4 inputs are hashed at once
+ *
+ * @param inputs  data to hash
+ */
+export function sha256Batch(inputs: Uint8Array[]): Uint8Array[] {
+  const out = new Uint8Array(inputs.length * 32)
+  sha256BatchInto(inputs, out)
 
-  const result = getUint8Memory().slice(outputPtr, outputPtr + size)
-  wasm.__free(inputPtr)
-  wasm.__free(outputPtr)
+  const result: Uint8Array[] = []
+  for (let i = 0; i < inputs.length; i++) {
+    result.push(out.subarray(i * 32, i * 32 + 32))
+  }
 
   return result
 }
 
 /**
- * Pefrorm AES-IGE-256 encryption
+ * Create a context for streaming SHA-256 hashing
  *
- * @param data  data to encrypt (must be a multiple of 16 bytes)
- * @param key  encryption key (32 bytes)
- * @param iv  initialization vector (32 bytes)
+ * > **Note**: `freeSha256` must be called on the returned context when it's no longer needed
  */
-export function ige256Encrypt(data: Uint8Array, key: Uint8Array, iv: Uint8Array): Uint8Array {
-  const ptr = wasm.__malloc(data.length + data.length)
+export function createSha256(): number {
+  return wasm.sha256_alloc()
+}
 
-  const inputPtr = ptr
-  const outputPtr = inputPtr + data.length
+/**
+ * Create a copy of a SHA-256 context, including all the data hashed so far
+ *
+ * > **Note**: `freeSha256` must be called on the returned context when it's no longer needed
+ */
+export function cloneSha256(ctx: number): number {
+  return wasm.sha256_clone(ctx)
+}
 
-  const mem = getUint8Memory()
-  mem.set(data, inputPtr)
-  mem.set(key, sharedKeyPtr)
-  mem.set(iv, sharedIvPtr)
+/**
+ * Release a context for streaming SHA-256 hashing
+ */
+export function freeSha256(ctx: number): void {
+  wasm.sha256_free(ctx)
+}
 
-  wasm.ige256_encrypt(inputPtr, data.length, outputPtr)
-  const result = mem.slice(outputPtr, outputPtr + data.length)
+/**
+ * Reset a SHA-256 context to its initial state, discarding any data hashed so far
+ */
+export function resetSha256(ctx: number): void {
+  wasm.sha256_reset(ctx)
+}
 
-  wasm.__free(ptr)
+/**
+ * Add data to a SHA-256 context
+ *
+ * @param ctx  context returned by `createSha256`
+ * @param data  data to hash
+ */
+export function sha256Update(ctx: number, data: Uint8Array): void {
+  stage(data, null, 0)
+  wasm.sha256_update(ctx, stagedIn, stagedLength)
+}
 
-  return result
+/**
+ * Finish hashing and write the digest to `out`.
+ * The context is reset afterwards, and can be reused
+ *
+ * @param ctx  context returned by `createSha256`
+ * @param out  output buffer (at least 32 bytes)
+ */
+export function sha256DigestInto(ctx: number, out: Uint8Array): void {
+  checkOutput(out, 32)
+
+  if (out.buffer === wasm.memory.buffer) {
+    wasm.sha256_final(ctx, out.byteOffset)
+  } else {
+    wasm.sha256_final(ctx, sharedOutPtr)
+    out.set(getUint8Memory().subarray(sharedOutPtr, sharedOutPtr + 32))
+  }
 }
 
 /**
- * Pefrorm AES-IGE-256 decryption
+ * Finish hashing and return the digest.
+ * The context is reset afterwards, and can be reused
  *
- * @param data  data to decrypt (must be a multiple of 16 bytes)
- * @param key  encryption key (32 bytes)
- * @param iv  initialization vector (32 bytes)
+ * @param ctx  context returned by `createSha256`
  */
-export function ige256Decrypt(data: Uint8Array, key: Uint8Array, iv: Uint8Array): Uint8Array {
-  const ptr = wasm.__malloc(data.length + data.length)
+export function sha256Digest(ctx: number): Uint8Array {
+  wasm.sha256_final(ctx, sharedOutPtr)
 
-  const inputPtr = ptr
-  const outputPtr = inputPtr + data.length
+  return getUint8Memory().slice(sharedOutPtr, sharedOutPtr + 32)
+}
 
-  const mem = getUint8Memory()
-  mem.set(data, inputPtr)
-  mem.set(key, sharedKeyPtr)
-  mem.set(iv, sharedIvPtr)
+/**
+ * Calculate a SHA-1 hash, writing it to `out`
+ *
+ * @param data  data to hash
+ * @param out  output buffer (at least 20 bytes)
+ */
+export function sha1Into(data: Uint8Array, out: Uint8Array): void {
+  checkOutput(out, 20)
+  stage(data, out, 0)
 
-  wasm.ige256_decrypt(inputPtr, data.length, outputPtr)
-  const result = mem.slice(outputPtr, outputPtr + data.length)
+  wasm.sha1(stagedIn, stagedLength)
+  unstage(out, sharedOutPtr, 20)
+}
 
-  wasm.__free(ptr)
+/**
+ * Calculate a SHA-1 hash
+ *
+ * @param data  data to hash
+ */
+export function sha1(data: Uint8Array): Uint8Array {
+  stage(data, null, 0)
+  wasm.sha1(stagedIn, stagedLength)
 
-  return result
+  return getUint8Memory().slice(sharedOutPtr, sharedOutPtr + 20)
 }
 
 /**
- * Create a context for AES-CTR-256 en/decryption
+ * Create a context for streaming SHA-1 hashing
  *
- * > **Note**: `freeCtr256` must be called on the returned context when it's no longer needed
+ * > **Note**: `freeSha1` must be called on the returned context when it's no longer needed
  */
-export function createCtr256(key: Uint8Array, iv: Uint8Array): number {
-  getUint8Memory().set(key, sharedKeyPtr)
-  getUint8Memory().set(iv, sharedIvPtr)
+export function createSha1(): number {
+  return wasm.sha1_alloc()
+}
 
-  return wasm.ctr256_alloc()
+/**
+ * Create a copy of a SHA-1 context, including all the data hashed so far
+ *
+ * > **Note**: `freeSha1` must be called on the returned context when it's no longer needed
+ */
+export function cloneSha1(ctx: number): number {
+  return wasm.sha1_clone(ctx)
 }
 
 /**
- * Release a context for AES-CTR-256 en/decryption
+ * Release a context for streaming SHA-1 hashing
  */
-export function freeCtr256(ctx: number): void {
-  wasm.ctr256_free(ctx)
+export function freeSha1(ctx: number): void {
+  wasm.sha1_free(ctx)
 }
 
 /**
- * Pefrorm AES-CTR-256 en/decryption
+ * Reset a SHA-1 context to its initial state, discarding any data hashed so far
+ */
+export function resetSha1(ctx: number): void {
+  wasm.sha1_reset(ctx)
+}
+
+/**
+ * Add data to a SHA-1 context
  *
- * @param ctx  context returned by `createCtr256`
- * @param data  data to en/decrypt (must be a multiple of 16 bytes)
+ * @param ctx  context returned by `createSha1`
+ * @param data  data to hash
  */
-export function ctr256(ctx: number, data: Uint8Array): Uint8Array {
-  const { __malloc, __free } = wasm
-  const inputPtr = __malloc(data.length)
-  const outputPtr = __malloc(data.length)
+export function sha1Update(ctx: number, data: Uint8Array): void {
+  stage(data, null, 0)
+  wasm.sha1_update(ctx, stagedIn, stagedLength)
+}
 
-  const mem = getUint8Memory()
-  mem.set(data, inputPtr)
+/**
+ * Finish hashing and write the digest to `out`.
+ * The context is reset afterwards, and can be reused
+ *
+ * @param ctx  context returned by `createSha1`
+ * @param out  output buffer (at least 20 bytes)
+ */
+export function sha1DigestInto(ctx: number, out: Uint8Array): void {
+  checkOutput(out, 20)
 
-  wasm.ctr256(ctx, inputPtr, data.length, outputPtr)
-  __free(inputPtr)
+  if (out.buffer === wasm.memory.buffer) {
+    wasm.sha1_final(ctx, out.byteOffset)
+  } else {
+    wasm.sha1_final(ctx, sharedOutPtr)
+    out.set(getUint8Memory().subarray(sharedOutPtr, sharedOutPtr + 20))
+  }
+}
 
-  const result = mem.slice(outputPtr, outputPtr + data.length)
-  __free(outputPtr)
+/**
+ * Finish hashing and return the digest.
+ * The context is reset afterwards, and can be reused
+ *
+ * @param ctx  context returned by `createSha1`
+ */
+export function sha1Digest(ctx: number): Uint8Array {
+  wasm.sha1_final(ctx, sharedOutPtr)
 
-  return result
+  return getUint8Memory().slice(sharedOutPtr, sharedOutPtr + 20)
 }
 
 /**
- * Calculate a SHA-256 hash
+ * Create a reusable HMAC-SHA256 key. The states after absorbing the padded key are
+ * precomputed, so hashing a message with it does not involve the key anymore
+ *
+ * > **Note**: `freeHmacSha256` must be called on the returned key when it's no longer needed
+ *
+ * @param key  HMAC key
+ */
+export function createHmacSha256(key: Uint8Array): number {
+  stage(key, null, 0)
+
+  return wasm.hmac_sha256_alloc(stagedIn, stagedLength)
+}
+
+/**
+ * Release a key created by `createHmacSha256`
+ */
+export function freeHmacSha256(ctx: number): void {
+  wasm.hmac_sha256_free(ctx)
+}
+
+/**
+ * Calculate HMAC-SHA256 of `data`, writing it to `out`
+ *
+ * @param ctx  key returned by `createHmacSha256`
+ * @param data  data to authenticate
+ * @param out  output buffer (at least 32 bytes)
+ */
+export function hmacSha256Into(ctx: number, data: Uint8Array, out: Uint8Array): void {
+  checkOutput(out, 32)
+  stage(data, out, 0)
+
+  wasm.hmac_sha256(ctx, stagedIn, stagedLength, sharedOutPtr)
+  unstage(out, sharedOutPtr, 32)
+}
+
+/**
+ * Calculate HMAC-SHA256 of `data`
+ *
+ * @param ctx  key returned by `createHmacSha256`
+ * @param data  data to authenticate
+ */
+export function hmacSha256(ctx: number, data: Uint8Array): Uint8Array {
+  stage(data, null, 0)
+  wasm.hmac_sha256(ctx, stagedIn, stagedLength, sharedOutPtr)
+
+  return getUint8Memory().slice(sharedOutPtr, sharedOutPtr + 32)
+}
+
+/**
+ * Calculate a SHA-512 hash
  *
  * @param data  data to hash
  */
-export function sha256(data: Uint8Array): Uint8Array {
-  const { __malloc, __free } = wasm
-  const inputPtr = __malloc(data.length)
+export function sha512(data: Uint8Array): Uint8Array {
+  stage(data, null, 0)
+  wasm.sha512(stagedIn, stagedLength)
+
+  return getUint8Memory().slice(sharedOutPtr, sharedOutPtr + 64)
+}
+
+/**
+ * Derive a key with PBKDF2-HMAC-SHA512. The whole iteration loop runs inside WASM
+ *
+ * @param password  password
+ * @param salt  salt
+ * @param iterations  number of iterations
+ * @param keylen  length of the derived key
+ */
+export function pbkdf2Sha512(password: Uint8Array, salt: Uint8Array, iterations: number, keylen = 64): Uint8Array {
+  const table = stageSlices([password, salt], keylen)
+  const iov = new Uint32Array(wasm.memory.buffer, table, 4)
+
+  wasm.pbkdf2_sha512(iov[0], iov[1], iov[2], iov[3], iterations, stagedOut, keylen)
+
+  return getUint8Memory().slice(stagedOut, stagedOut + keylen)
+}
+
+/**
+ * Calculate `base^exp mod mod` with Montgomery multiplication.
+ * All numbers are big-endian, and the modulus must be odd and at most 4096 bits long
+ *
+ * @param base  base, may be larger than the modulus
+ * @param exp  exponent
+ * @param mod  modulus
+ * @returns  result, padded to the length of `mod`
+ */
+export function modPow(base: Uint8Array, exp: Uint8Array, mod: Uint8Array): Uint8Array {
+  const modLen = mod.length
+  const table = stageSlices([base, exp, mod], modLen)
+  const iov = new Uint32Array(wasm.memory.buffer, table, 6)
+
+  if (wasm.modpow(iov[0], iov[1], iov[2], iov[3], iov[4], iov[5], stagedOut) < 0) {
+    throw new RangeError('modulus must be odd and at most 4096 bits long')
+  }
+
+  return getUint8Memory().slice(stagedOut, stagedOut + modLen)
+}
+
+function trimLeadingZeros(buf: Uint8Array): Uint8Array {
+  let i = 0
+  while (i < buf.length - 1 && buf[i] === 0) i++
+
+  return buf.slice(i)
+}
+
+/**
+ * Factorize `pq` from the MTProto handshake into `p` and `q` (`p <= q`)
+ * using Pollard's rho algorithm
+ *
+ * @param pq  big-endian number, at most 64 bits long
+ * @returns  `[p, q]` as big-endian numbers without leading zeros, or `null` if `pq` couldn't be factorized
+ */
+export function factorizePQ(pq: Uint8Array): [Uint8Array, Uint8Array] | null {
+  stage(pq, null, 0)
+
+  if (!wasm.factorize_pq(stagedIn, stagedLength, sharedOutPtr)) return null
 
   const mem = getUint8Memory()
-  mem.set(data, inputPtr)
 
-  wasm.sha256(inputPtr, data.length)
-  __free(inputPtr)
+  return [
+    trimLeadingZeros(mem.subarray(sharedOutPtr, sharedOutPtr + 8)),
+    trimLeadingZeros(mem.subarray(sharedOutPtr + 8, sharedOutPtr + 16)),
+  ]
+}
+
+/**
+ * Check whether a number is (probably) prime using the Miller-Rabin test.
+ * Numbers that were found to be prime are cached by their hash along with the number of rounds,
+ * so checking the same number again with as many rounds or fewer is almost free
+ *
+ * @param num  big-endian number, at most 4096 bits long
+ * @param randomFill  function used to generate random bases
+ * @param rounds  number of rounds
+ */
+export function isProbablePrime(num: Uint8Array, randomFill: (buf: Uint8Array) => void, rounds = 20): boolean {
+  stage(num, null, 0)
+  let res = wasm.is_probable_prime(stagedIn, stagedLength, 0, rounds)
+
+  if (res === -1) {
+    const random = new Uint8Array(num.length * rounds)
+    randomFill(random)
 
-  return mem.slice(sharedOutPtr, sharedOutPtr + 32)
+    const table = stageSlices([num, random], 0)
+    const iov = new Uint32Array(wasm.memory.buffer, table, 4)
+
+    res = wasm.is_probable_prime(iov[0], iov[1], iov[2], rounds)
+  }
+
+  if (res === -2) throw new RangeError('number must be at most 4096 bits long')
+
+  return res === 1
 }
 
+function writeInt32(mem: Uint8Array, offset: number, value: number): void {
+  mem[offset] = value
+  mem[offset + 1] = value >>> 8
+  mem[offset + 2] = value >>> 16
+  mem[offset + 3] = value >>> 24
+}
+
+const MTPROTO_ERR_HANDLE = -3
+
 /**
- * Calculate a SHA-1 hash
+ * Register an auth key in WASM memory, so that it doesn't have to be
+ * uploaded again for every message
  *
- * @param data  data to hash
+ * > **Note**: `authKeyRelease` must be called on the returned handle when it's no longer needed
+ *
+ * @param key  auth key (256 bytes)
+ * @returns  handle to be passed to `encryptMessage` and `decryptMessage`
  */
-export function sha1(data: Uint8Array): Uint8Array {
-  const { __malloc, __free } = wasm
-  const inputPtr = __malloc(data.length)
+export function authKeyRegister(key: Uint8Array): number {
+  if (key.length !== 256) throw new Error('auth key must be 256 bytes long')
+
+  getUint8Memory().set(key, sharedOutPtr)
+
+  const handle = wasm.mtproto_auth_key_register()
+  if (handle === 0) throw new RangeError('failed to allocate WASM memory for the auth key')
+
+  return handle
+}
+
+/**
+ * Release an auth key registered with `authKeyRegister`.
+ * The key is wiped from WASM memory, and the handle must not be used anymore
+ */
+export function authKeyRelease(handle: number): void {
+  wasm.mtproto_auth_key_release(handle)
+}
+
+/**
+ * Encrypt a message as defined by MTProto 2.0, in a single call to the WASM module
+ *
+ * @param authKey  auth key handle returned by `authKeyRegister`
+ * @param message  message to encrypt (starting with message id)
+ * @param serverSalt  server salt
+ * @param sessionId  session id
+ * @param randomFill  function used to fill the padding with random bytes
+ * @returns  `auth_key_id || msg_key || encrypted_data`
+ */
+export function encryptMessage(
+  authKey: number,
+  message: Uint8Array,
+  serverSalt: Int64Like,
+  sessionId: Int64Like,
+  randomFill: (buf: Uint8Array) => void,
+): Uint8Array {
+  let padding = (16 /* header size */ + message.length + 12) /* min padding */ % 16
+  padding = 12 + (padding ? 16 - padding : 0)
+
+  const length = 16 + message.length + padding
+  const ptr = malloc(24 + length)
 
   const mem = getUint8Memory()
-  mem.set(data, inputPtr)
+  writeInt32(mem, ptr + 24, serverSalt.low)
+  writeInt32(mem, ptr + 28, serverSalt.high)
+  writeInt32(mem, ptr + 32, sessionId.low)
+  writeInt32(mem, ptr + 36, sessionId.high)
+  mem.set(message, ptr + 40)
+  randomFill(mem.subarray(ptr + 40 + message.length, ptr + 24 + length))
 
-  wasm.sha1(inputPtr, data.length)
-  __free(inputPtr)
+  if (wasm.mtproto_encrypt_message(authKey, ptr, length) === MTPROTO_ERR_HANDLE) {
+    wasm.__free(ptr)
+    throw new Error('invalid auth key handle')
+  }
+
+  const result = mem.slice(ptr, ptr + 24 + length)
+  wasm.__free(ptr)
+
+  return result
+}
+
+/**
+ * Decrypt a server message as defined by MTProto 2.0 and verify its msg_key, in a single call to the WASM module.
+ * The message is decrypted in place: a view of WASM memory (e.g. from {@link getStagingBuffers})
+ * is used as is and will be overwritten, anything else is copied into the scratch area first
+ *
+ * > **Note**: to avoid copying, `callback` receives a view into WASM memory, which is only valid
+ * > until the callback returns. Anything that needs to outlive it must be copied
+ *
+ * @param authKey  auth key handle returned by `authKeyRegister`
+ * @param data  `auth_key_id || msg_key || encrypted_data`
+ * @param callback  function receiving the decrypted data (`salt || session_id || message || padding`)
+ * @returns  `false` if the message was too short or msg_key did not match, `true` otherwise
+ */
+export function decryptMessage(
+  authKey: number,
+  data: Uint8Array,
+  callback: (data: Uint8Array) => void,
+): boolean {
+  stage(data, null, 0)
+
+  const ptr = stagedIn
+  const length = wasm.mtproto_decrypt_message(authKey, ptr, data.length)
+
+  if (length === MTPROTO_ERR_HANDLE) throw new Error('invalid auth key handle')
+  if (length < 0) return false
+
+  if (ptr !== scratchPtr) {
+    callback(getUint8Memory().subarray(ptr + 24, ptr + 24 + length))
+
+    return true
+  }
 
-  return mem.slice(sharedOutPtr, sharedOutPtr + 20)
+  // the callback may call into the module again, so the scratch area is taken away
+  // from `stage` until it returns, otherwise the view could be overwritten
+  const ownPtr = scratchPtr
+  const ownSize = scratchSize
+  scratchPtr = 0
+  scratchSize = 0
+
+  try {
+    callback(getUint8Memory().subarray(ptr + 24, ptr + 24 + length))
+  } finally {
+    if (ownSize > scratchSize) {
+      wasm.__free(scratchPtr)
+      scratchPtr = ownPtr
+      scratchSize = ownSize
+    } else {
+      wasm.__free(ownPtr)
+    }
+  }
+
+  return true
+}
+
+/**
+ * Get memory usage statistics of the WASM module.
+ *
+ * The counters are always maintained, so this is cheap enough to be polled
+ * periodically (e.g. to alert on heap growth)
+ */
+export function getWasmStats(): WasmStats {
+  const ptr = wasm.__get_allocator_stats()
+  const view = new Uint32Array(wasm.memory.buffer, ptr, 14)
+
+  return {
+    memorySize: wasm.memory.buffer.byteLength,
+    liveBytes: view[0],
+    peakLiveBytes: view[1],
+    heapBytes: view[2],
+    memoryGrowCount: view[3],
+    mallocCount: view[4],
+    freeCount: view[5],
+    fragmentedBytes: Array.from(view.subarray(6, 14)),
+  }
+}
+
+/**
+ * Check whether the loaded WASM module has the given export.
+ *
+ * Useful when the module may come from elsewhere (e.g. a custom URL passed to the web client)
+ * and be an older build that lacks some of the newer functions
+ */
+export function hasWasmExport(name: keyof MtcuteWasmModule): boolean {
+  return typeof wasm[name] === 'function'
 }
 
 /**
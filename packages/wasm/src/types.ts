@@ -4,6 +4,7 @@ export interface MtcuteWasmModule {
   __free: (ptr: number) => void
 
   __get_shared_out: () => number
+  __get_allocator_stats: () => number
   __get_shared_key_buffer: () => number
   __get_shared_iv_buffer: () => number
 
@@ -16,6 +17,28 @@ export interface MtcuteWasmModule {
 
   libdeflate_zlib_compress: (ctx: number, src: number, srcLen: number, dst: number, dstLen: number) => number
 
+  /** @returns  size of the written gzip_packed object, 0 if it doesn't fit into `dstLen` bytes */
+  gzip_packed_compress: (ctx: number, src: number, srcLen: number, dst: number, dstLen: number) => number
+
+  zlib_stream_alloc: (compressor: number) => number
+  zlib_stream_free: (ctx: number) => void
+  /** @returns  number of bytes consumed, less than `dataLen` if the output has to be pulled first */
+  zlib_stream_push: (ctx: number, data: number, dataLen: number) => number
+  zlib_stream_finish: (ctx: number) => void
+  /** @returns  number of bytes written, 0 if more input is needed or the stream has ended */
+  zlib_stream_pull: (ctx: number, out: number, outLen: number) => number
+
+  /** @returns  estimated ratio of compressed to original size, multiplied by 1024 */
+  estimate_compressibility: (data: number, dataLen: number) => number
+
+  gunzip_stream_alloc: (maxOutput: number) => number
+  gunzip_stream_free: (ctx: number) => void
+  /** the data is copied, so it can be released right away */
+  gunzip_stream_push: (ctx: number, data: number, dataLen: number) => number
+  /** @returns  number of bytes written, -1 if the data is invalid, -2 if the output exceeds `maxOutput` */
+  gunzip_stream_pull: (ctx: number, out: number, outLen: number) => number
+  gunzip_stream_finished: (ctx: number) => number
+
   ige256_encrypt: (data: number, dataLen: number, out: number) => void
 
   ige256_decrypt: (data: number, dataLen: number, out: number) => void
@@ -25,7 +48,105 @@ export interface MtcuteWasmModule {
   ctr256: (ctx: number, data: number, dataLen: number, out: number) => number
 
   sha256: (data: number, dataLen: number) => void
+  /** `inputs` is an array of `count` (ptr, len) pairs, digests are written one after another to `out` */
+  sha256_multi: (inputs: number, count: number, out: number) => void
+  /** `iov` is an array of `count` (ptr, len) pairs, the digest of their concatenation is written to `out` */
+  sha256_iov: (iov: number, count: number, out: number) => void
+  sha256_alloc: () => number
+  sha256_clone: (ctx: number) => number
+  sha256_free: (ctx: number) => void
+  sha256_reset: (ctx: number) => void
+  sha256_update: (ctx: number, data: number, dataLen: number) => void
+  /** writes the digest to `out` and resets the context */
+  sha256_final: (ctx: number, out: number) => void
   sha1: (data: number, dataLen: number) => void
+  /** `iov` is an array of `count` (ptr, len) pairs, the digest of their concatenation is written to `out` */
+  sha1_iov: (iov: number, count: number, out: number) => void
+  sha1_alloc: () => number
+  sha1_clone: (ctx: number) => number
+  sha1_free: (ctx: number) => void
+  sha1_reset: (ctx: number) => void
+  sha1_update: (ctx: number, data: number, dataLen: number) => void
+  /** writes the digest to `out` and resets the context */
+  sha1_final: (ctx: number, out: number) => void
+  /** precomputes the inner and outer states for `key` */
+  hmac_sha256_alloc: (key: number, keyLen: number) => number
+  hmac_sha256_free: (ctx: number) => void
+  hmac_sha256: (ctx: number, data: number, dataLen: number, out: number) => void
+  sha512: (data: number, dataLen: number) => void
+  pbkdf2_sha512: (
+    password: number,
+    passwordLen: number,
+    salt: number,
+    saltLen: number,
+    iterations: number,
+    out: number,
+    outLen: number,
+  ) => void
+
+  /** @returns  -1 if the modulus is even or longer than 4096 bits */
+  modpow: (
+    base: number,
+    baseLen: number,
+    exp: number,
+    expLen: number,
+    mod: number,
+    modLen: number,
+    out: number,
+  ) => number
+  /** @returns  0 if `pq` was not factorized, otherwise p and q are written to `out` as 8-byte big-endian numbers */
+  factorize_pq: (pq: number, pqLen: number, out: number) => number
+  /**
+   * `random` is `rounds` random numbers of `numLen` bytes, or 0 to only check the cache.
+   * @returns  1 - probably prime, 0 - composite, -1 - not cached, -2 - longer than 4096 bits
+   */
+  is_probable_prime: (num: number, numLen: number, random: number, rounds: number) => number
+
+  /** reads the key from shared_out */
+  mtproto_auth_key_register: () => number
+  mtproto_auth_key_release: (handle: number) => void
+  /** @returns  if <0 - error */
+  mtproto_encrypt_message: (authKey: number, buf: number, length: number) => number
+  /** @returns  length of the plaintext at `buf + 24`, or <0 - error */
+  mtproto_decrypt_message: (authKey: number, buf: number, length: number) => number
+}
+
+export interface DeflateOptions {
+  /**
+   * Compression level, from 0 (no compression) to 12 (slowest).
+   *
+   * By default it depends on the size of the input: 1 for inputs smaller than 2 KB,
+   * 9 for inputs of 256 KB and larger, and 6 for everything in between
+   */
+  level?: number
+}
+
+export interface WasmStats {
+  /** size of the WASM linear memory, in bytes (it never shrinks) */
+  memorySize: number
+  /** bytes currently allocated, including allocator overhead */
+  liveBytes: number
+  /** maximum value of `liveBytes` since the module was loaded */
+  peakLiveBytes: number
+  /** bytes of memory currently managed by the allocator (allocated or free) */
+  heapBytes: number
+  /** number of times the memory had to be grown */
+  memoryGrowCount: number
+  /** number of allocations since the module was loaded */
+  mallocCount: number
+  /** number of frees since the module was loaded */
+  freeCount: number
+  /**
+   * bytes in free blocks that can't be returned to the end of the heap, by block size:
+   * `<128`, `<512`, `<2K`, `<8K`, `<32K`, `<128K`, `<512K`, `>=512K`
+   */
+  fragmentedBytes: number[]
+}
+
+/** 64-bit integer represented as two 32-bit halves (compatible with `Long`) */
+export interface Int64Like {
+  low: number
+  high: number
 }
 
 export type SyncInitInput = BufferSource | WebAssembly.Module | WebAssembly.Instance
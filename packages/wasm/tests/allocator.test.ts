@@ -1,6 +1,6 @@
 import { beforeAll, describe, expect, it } from 'vitest'
 
-import { __getWasm } from '../src/index.js'
+import { __getWasm, getWasmStats } from '../src/index.js'
 
 import { initWasm } from './init.js'
 
@@ -20,4 +20,63 @@ describe('allocator', () => {
 
     expect(wasm.memory.buffer.byteLength).toEqual(memUsage)
   })
+
+  it('should reuse memory freed out of order', () => {
+    const wasm = __getWasm()
+
+    // make sure there's enough memory for the long-lived blocks
+    wasm.__free(wasm.__malloc(1024 * 1024))
+    const memUsage = wasm.memory.buffer.byteLength
+
+    const pinned: number[] = []
+
+    for (let i = 0; i < 1024; i++) {
+      const transient = wasm.__malloc(4096)
+      pinned.push(wasm.__malloc(256))
+      wasm.__free(transient)
+    }
+
+    for (const ptr of pinned) wasm.__free(ptr)
+
+    expect(wasm.memory.buffer.byteLength).toEqual(memUsage)
+  })
+
+  it('should return 16-byte aligned pointers', () => {
+    const wasm = __getWasm()
+    const ptrs = [1, 3, 17, 100, 1000, 5000].map(size => wasm.__malloc(size))
+
+    for (const ptr of ptrs) {
+      expect(ptr % 16).toEqual(0)
+    }
+
+    for (const ptr of ptrs) wasm.__free(ptr)
+  })
+
+  it('should report allocator statistics', () => {
+    const wasm = __getWasm()
+    const before = getWasmStats()
+
+    const a = wasm.__malloc(1000)
+    const b = wasm.__malloc(1000)
+    const c = wasm.__malloc(1000)
+
+    const during = getWasmStats()
+
+    expect(during.mallocCount).toEqual(before.mallocCount + 3)
+    expect(during.liveBytes).toBeGreaterThanOrEqual(before.liveBytes + 3000)
+    expect(during.peakLiveBytes).toBeGreaterThanOrEqual(during.liveBytes)
+
+    // b can't be merged with its neighbours, so it's counted as fragmented
+    wasm.__free(b)
+    expect(getWasmStats().fragmentedBytes.reduce((acc, it) => acc + it, 0)).toBeGreaterThan(0)
+
+    wasm.__free(a)
+    wasm.__free(c)
+
+    const after = getWasmStats()
+
+    expect(after.freeCount).toEqual(before.freeCount + 3)
+    expect(after.liveBytes).toEqual(before.liveBytes)
+    expect(after.memorySize).toEqual(wasm.memory.buffer.byteLength)
+  })
 })
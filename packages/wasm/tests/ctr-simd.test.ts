@@ -126,6 +126,30 @@ describe('aes-ctr (simd)', () => {
     })
   })
 
+  describe('stream (multi-block)', () => {
+    const data = new Uint8Array(1000).map((_, i) => i * 7)
+
+    it('should produce the same stream regardless of chunking', () => {
+      const ctrWhole = createCtr256(key, iv)
+      const expected = ctr256(ctrWhole, data)
+      freeCtr256(ctrWhole)
+
+      const ctr = createCtr256(key, iv)
+      const res = new Uint8Array(data.length)
+      let offset = 0
+
+      for (const size of [5, 11, 64, 3, 130, 1, 255, 16, 79]) {
+        res.set(ctr256(ctr, data.subarray(offset, offset + size)), offset)
+        offset += size
+      }
+      res.set(ctr256(ctr, data.subarray(offset)), offset)
+
+      freeCtr256(ctr)
+
+      expect(hex.encode(res)).toEqual(hex.encode(expected))
+    })
+  })
+
   it('should not leak memory', () => {
     const data = hex.decode('6BC1BEE22E409F96E93D7E117393172A')
     const mem = __getWasm().memory.buffer
@@ -1,7 +1,7 @@
 import { hex } from '@fuman/utils'
 import { beforeAll, describe, expect, it } from 'vitest'
 
-import { __getWasm, createCtr256, ctr256, freeCtr256 } from '../src/index.js'
+import { __getWasm, createCtr256, ctr256, ctr256InPlace, freeCtr256 } from '../src/index.js'
 
 import { initWasm } from './init.js'
 
@@ -36,6 +36,16 @@ describe('aes-ctr', () => {
       expect(hex.encode(res)).toEqual(hex.encode(dataEnc))
     })
 
+    it('should correctly encrypt in place', () => {
+      const ctr = createCtr256(key, iv)
+      const buf = data.slice()
+      ctr256InPlace(ctr, buf.subarray(0, 20))
+      ctr256InPlace(ctr, buf.subarray(20))
+      freeCtr256(ctr)
+
+      expect(hex.encode(buf)).toEqual(hex.encode(dataEnc))
+    })
+
     it('should correctly decrypt', () => {
       const ctr = createCtr256(key, iv)
       const res = ctr256(ctr, dataEnc)
@@ -126,6 +136,30 @@ describe('aes-ctr', () => {
     })
   })
 
+  describe('stream (multi-block)', () => {
+    const data = new Uint8Array(1000).map((_, i) => i * 7)
+
+    it('should produce the same stream regardless of chunking', () => {
+      const ctrWhole = createCtr256(key, iv)
+      const expected = ctr256(ctrWhole, data)
+      freeCtr256(ctrWhole)
+
+      const ctr = createCtr256(key, iv)
+      const res = new Uint8Array(data.length)
+      let offset = 0
+
+      for (const size of [5, 11, 64, 3, 130, 1, 255, 16, 79]) {
+        res.set(ctr256(ctr, data.subarray(offset, offset + size)), offset)
+        offset += size
+      }
+      res.set(ctr256(ctr, data.subarray(offset)), offset)
+
+      freeCtr256(ctr)
+
+      expect(hex.encode(res)).toEqual(hex.encode(expected))
+    })
+  })
+
   it('should not leak memory', () => {
     const data = hex.decode('6BC1BEE22E409F96E93D7E117393172A')
     const mem = __getWasm().memory.buffer
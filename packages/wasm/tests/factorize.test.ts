@@ -0,0 +1,36 @@
+import { bigint } from '@fuman/utils'
+import { beforeAll, describe, expect, it } from 'vitest'
+
+import { factorizePQ } from '../src/index.js'
+
+import { initWasm } from './init.js'
+
+beforeAll(async () => {
+  await initWasm()
+})
+
+describe('factorizePQ', () => {
+  const testFactorization = (pq: bigint, p: bigint, q: bigint) => {
+    const res = factorizePQ(bigint.toBytes(pq))
+
+    expect(res).not.toBeNull()
+    expect(bigint.fromBytes(res![0])).toBe(p)
+    expect(bigint.fromBytes(res![1])).toBe(q)
+  }
+
+  it('should factorize', () => {
+    testFactorization(2090522174869285481n, 1112973847n, 1878321023n)
+    testFactorization(1470626929934143021n, 1206429347n, 1218991343n)
+    testFactorization(2804275833720261793n, 1555252417n, 1803100129n)
+  })
+
+  it('should factorize small and even numbers', () => {
+    testFactorization(15n, 3n, 5n)
+    testFactorization(2000006n, 2n, 1000003n)
+  })
+
+  it('should return null for primes and oversized numbers', () => {
+    expect(factorizePQ(bigint.toBytes(18446744073709551557n))).toBeNull()
+    expect(factorizePQ(bigint.toBytes(2n ** 64n + 1n))).toBeNull()
+  })
+})
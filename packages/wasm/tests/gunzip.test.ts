@@ -3,7 +3,16 @@ import { gzipSync } from 'node:zlib'
 import { utf8 } from '@fuman/utils'
 import { beforeAll, describe, expect, it } from 'vitest'
 
-import { __getWasm, gunzip } from '../src/index.js'
+import {
+  __getWasm,
+  createGunzip,
+  freeGunzip,
+  gunzip,
+  gunzipChunked,
+  gunzipFinished,
+  gunzipPullInto,
+  gunzipPush,
+} from '../src/index.js'
 
 import { initWasm } from './init.js'
 
@@ -57,3 +66,86 @@ describe('gunzip', () => {
     expect(__getWasm().memory.buffer.byteLength).toEqual(memSize)
   })
 })
+
+describe('gunzip streaming', () => {
+  // compressible, but not trivially
+  const data = new Uint8Array(300000)
+  for (let i = 0; i < data.length; i++) data[i] = (i * 7 + (i >> 10)) % 61
+
+  // copied, since `Buffer#slice` returns a view and the tests below modify copies of it
+  const gzipped = new Uint8Array(gzipSyncWrap(data))
+
+  it('should inflate with any chunk sizes', () => {
+    for (const [inChunk, outChunk] of [[1, 7], [13, 1000], [4096, 65536], [1000000, 300]]) {
+      const ctx = createGunzip()
+      const out = new Uint8Array(data.length)
+      let outPos = 0
+      let inPos = 0
+
+      while (!gunzipFinished(ctx)) {
+        const written = gunzipPullInto(ctx, out.subarray(outPos, outPos + outChunk))
+        outPos += written
+
+        if (written < outChunk && !gunzipFinished(ctx)) {
+          gunzipPush(ctx, gzipped.subarray(inPos, inPos + inChunk))
+          inPos += inChunk
+        }
+      }
+
+      freeGunzip(ctx)
+
+      expect(outPos).toEqual(data.length)
+      expect(out).toEqual(data)
+    }
+  })
+
+  it('should finish when the output buffer is exactly the size of the data', () => {
+    const ctx = createGunzip()
+    const out = new Uint8Array(data.length)
+
+    gunzipPush(ctx, gzipped)
+    expect(gunzipPullInto(ctx, out)).toEqual(data.length)
+    expect(gunzipPullInto(ctx, new Uint8Array(0))).toEqual(0)
+    expect(gunzipFinished(ctx)).toBe(true)
+    freeGunzip(ctx)
+
+    expect(out).toEqual(data)
+  })
+
+  it('should inflate in chunks', () => {
+    expect(gunzipChunked(gzipped, data.length, 1024)).toEqual(data)
+    expect(gunzipChunked(gzipSyncWrap(new Uint8Array(0)))).toEqual(new Uint8Array(0))
+  })
+
+  it('should enforce the output limit', () => {
+    expect(() => gunzipChunked(gzipped, data.length - 1)).toThrow(RangeError)
+  })
+
+  it('should reject truncated and invalid data', () => {
+    expect(() => gunzipChunked(gzipped.subarray(0, 1000))).toThrow('short input')
+
+    const badSize = gzipped.slice()
+    badSize[badSize.length - 1] ^= 1
+    expect(() => gunzipChunked(badSize)).toThrow('bad data')
+
+    const badCrc = gzipped.slice()
+    badCrc[badCrc.length - 8] ^= 1
+    expect(() => gunzipChunked(badCrc)).toThrow('bad data')
+
+    const badHeader = gzipped.slice()
+    badHeader[0] = 0
+    expect(() => gunzipChunked(badHeader)).toThrow('bad data')
+  })
+
+  it('should not trust the declared output size', () => {
+    const memSize = __getWasm().memory.buffer.byteLength
+
+    // claim the output is ~4 GB
+    const lying = gzipSyncWrap(utf8.encoder.encode('hello world')).slice()
+    lying.fill(0xFF, lying.length - 4)
+
+    expect(() => gunzip(lying)).toThrow('bad data')
+    expect(gunzip(gzipped)).toEqual(data)
+    expect(__getWasm().memory.buffer.byteLength - memSize).toBeLessThan(1024 * 1024)
+  })
+})
@@ -1,7 +1,32 @@
 import { hex, utf8 } from '@fuman/utils'
 import { beforeAll, describe, expect, it } from 'vitest'
 
-import { __getWasm, sha1, sha256 } from '../src/index.js'
+import {
+  __getWasm,
+  cloneSha1,
+  cloneSha256,
+  createHmacSha256,
+  createSha1,
+  createSha256,
+  freeHmacSha256,
+  freeSha1,
+  freeSha256,
+  hmacSha256,
+  hmacSha256Into,
+  pbkdf2Sha512,
+  sha1,
+  sha1Digest,
+  sha1Update,
+  sha1v,
+  sha256,
+  sha256Batch,
+  sha256BatchInto,
+  sha256Digest,
+  sha256DigestInto,
+  sha256Update,
+  sha256v,
+  sha512,
+} from '../src/index.js'
 
 import { initWasm } from './init.js'
 
@@ -28,6 +53,61 @@ describe('sha256', () => {
   })
 })
 
+describe('sha256 (batch)', () => {
+  it('should hash independent inputs', () => {
+    // covers groups of 4 and the leftover, and lengths needing 1 or 2 padding blocks
+    const inputs = [0, 1, 55, 56, 64, 119, 1000].map(len => new Uint8Array(len).map((_, i) => i * len))
+    const hashes = sha256Batch(inputs)
+
+    expect(hashes.map(it => hex.encode(it))).toEqual(inputs.map(it => hex.encode(sha256(it))))
+  })
+
+  it('should write digests into the caller buffer', () => {
+    const inputs = [utf8.encoder.encode('abc'), utf8.encoder.encode('abd')]
+    const out = new Uint8Array(64)
+    sha256BatchInto(inputs, out)
+
+    expect(hex.encode(out.subarray(0, 32))).toEqual('ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad')
+    expect(out.subarray(32)).toEqual(sha256(inputs[1]))
+  })
+})
+
+describe('sha256 (streaming)', () => {
+  it('should correctly calculate hash of multiple chunks', () => {
+    const data = new Uint8Array(1000).map((_, i) => i * 7)
+
+    const ctx = createSha256()
+    sha256Update(ctx, data.subarray(0, 1))
+    sha256Update(ctx, data.subarray(1, 100))
+    sha256Update(ctx, data.subarray(100))
+
+    expect(hex.encode(sha256Digest(ctx))).toEqual(hex.encode(sha256(data)))
+
+    // context is reset after digest
+    sha256Update(ctx, utf8.encoder.encode('abc'))
+    const out = new Uint8Array(32)
+    sha256DigestInto(ctx, out)
+    expect(hex.encode(out)).toEqual('ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad')
+
+    freeSha256(ctx)
+  })
+
+  it('should clone contexts', () => {
+    const ctx = createSha256()
+    sha256Update(ctx, utf8.encoder.encode('ab'))
+
+    const clone = cloneSha256(ctx)
+    sha256Update(ctx, utf8.encoder.encode('c'))
+    sha256Update(clone, utf8.encoder.encode('d'))
+
+    expect(hex.encode(sha256Digest(ctx))).toEqual(hex.encode(sha256(utf8.encoder.encode('abc'))))
+    expect(hex.encode(sha256Digest(clone))).toEqual(hex.encode(sha256(utf8.encoder.encode('abd'))))
+
+    freeSha256(ctx)
+    freeSha256(clone)
+  })
+})
+
 describe('sha1', () => {
   it('should correctly calculate sha-1 hash', () => {
     const hash = sha1(utf8.encoder.encode('abc'))
@@ -46,3 +126,149 @@ describe('sha1', () => {
     expect(mem.byteLength).toEqual(memSize)
   })
 })
+
+describe('sha1 (streaming)', () => {
+  it('should correctly calculate hash of multiple chunks', () => {
+    const data = new Uint8Array(1000).map((_, i) => i * 7)
+
+    const ctx = createSha1()
+    sha1Update(ctx, data.subarray(0, 1))
+    sha1Update(ctx, data.subarray(1, 100))
+    sha1Update(ctx, data.subarray(100))
+
+    expect(hex.encode(sha1Digest(ctx))).toEqual(hex.encode(sha1(data)))
+
+    sha1Update(ctx, utf8.encoder.encode('abc'))
+    expect(hex.encode(sha1Digest(ctx))).toEqual('a9993e364706816aba3e25717850c26c9cd0d89d')
+
+    freeSha1(ctx)
+  })
+
+  it('should clone contexts', () => {
+    const ctx = createSha1()
+    sha1Update(ctx, utf8.encoder.encode('ab'))
+
+    const clone = cloneSha1(ctx)
+    sha1Update(ctx, utf8.encoder.encode('c'))
+    sha1Update(clone, utf8.encoder.encode('d'))
+
+    expect(hex.encode(sha1Digest(ctx))).toEqual(hex.encode(sha1(utf8.encoder.encode('abc'))))
+    expect(hex.encode(sha1Digest(clone))).toEqual(hex.encode(sha1(utf8.encoder.encode('abd'))))
+
+    freeSha1(ctx)
+    freeSha1(clone)
+  })
+
+  it('should handle lengths around the block boundary', () => {
+    // sha1 of 55, 56 and 64 'a's
+    const expected = [
+      'c1c8bbdc22796e28c0e15163d20899b65621d65a',
+      'c2db330f6083854c99d4b5bfb6e8f29f201be699',
+      '0098ba824b5c16427bd7a1122a5a442a25ec644d',
+    ]
+
+    for (const [i, len] of [55, 56, 64].entries()) {
+      expect(hex.encode(sha1(new Uint8Array(len).fill(0x61)))).toEqual(expected[i])
+    }
+  })
+})
+
+describe('scatter-gather hashing', () => {
+  it('should hash the concatenation of slices', () => {
+    const slices = [utf8.encoder.encode('a'), new Uint8Array(0), utf8.encoder.encode('bc')]
+
+    expect(hex.encode(sha256v(slices))).toEqual('ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad')
+    expect(hex.encode(sha1v(slices))).toEqual('a9993e364706816aba3e25717850c26c9cd0d89d')
+  })
+
+  it('should handle slices crossing block boundaries', () => {
+    const data = new Uint8Array(300).map((_, i) => i)
+    const slices = [data.subarray(0, 63), data.subarray(63, 65), data.subarray(65, 200), data.subarray(200)]
+
+    expect(sha256v(slices)).toEqual(sha256(data))
+    expect(sha1v(slices)).toEqual(sha1(data))
+  })
+})
+
+describe('hmac-sha256', () => {
+  // test cases 1, 2 and 6 from RFC 4231
+  const vectors = [
+    [
+      '0b'.repeat(20),
+      utf8.encoder.encode('Hi There'),
+      'b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7',
+    ],
+    [
+      hex.encode(utf8.encoder.encode('Jefe')),
+      utf8.encoder.encode('what do ya want for nothing?'),
+      '5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843',
+    ],
+    [
+      'aa'.repeat(131),
+      utf8.encoder.encode('Test Using Larger Than Block-Size Key - Hash Key First'),
+      '60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54',
+    ],
+  ] as const
+
+  it('should match RFC 4231 test vectors', () => {
+    for (const [key, data, expected] of vectors) {
+      const ctx = createHmacSha256(hex.decode(key))
+
+      expect(hex.encode(hmacSha256(ctx, data))).toEqual(expected)
+
+      freeHmacSha256(ctx)
+    }
+  })
+
+  it('should reuse the key for multiple messages', () => {
+    const ctx = createHmacSha256(hex.decode('0b'.repeat(20)))
+    const out = new Uint8Array(32)
+
+    for (let i = 0; i < 3; i++) {
+      hmacSha256Into(ctx, utf8.encoder.encode('Hi There'), out)
+      expect(hex.encode(out)).toEqual(vectors[0][2])
+    }
+
+    freeHmacSha256(ctx)
+  })
+})
+
+describe('sha512', () => {
+  it('should correctly calculate sha-512 hash', () => {
+    expect(hex.encode(sha512(utf8.encoder.encode('abc')))).toEqual(
+      'ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a'
+      + '2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f',
+    )
+  })
+
+  it('should handle inputs longer than a block', () => {
+    expect(hex.encode(sha512(new Uint8Array(200).fill(0x61)))).toEqual(
+      '4b11459c33f52a22ee8236782714c150a3b2c60994e9acee17fe68947a3e6789'
+      + 'f31e7668394592da7bef827cddca88c4e6f86e4df7ed1ae6cba71f3e98faee9f',
+    )
+  })
+})
+
+describe('pbkdf2-sha512', () => {
+  const password = utf8.encoder.encode('password')
+  const salt = utf8.encoder.encode('salt')
+
+  it('should derive a 64-byte key', () => {
+    expect(hex.encode(pbkdf2Sha512(password, salt, 1))).toEqual(
+      '867f70cf1ade02cff3752599a3a53dc4af34c7a669815ae5d513554e1c8cf252'
+      + 'c02d470a285a0501bad999bfe943c08f050235d7d68b1da55e63f73b60a57fce',
+    )
+    expect(hex.encode(pbkdf2Sha512(password, salt, 1000))).toEqual(
+      'afe6c5530785b6cc6b1c6453384731bd5ee432ee549fd42fb6695779ad8a1c5b'
+      + 'f59de69c48f774efc4007d5298f9033c0241d5ab69305e7b64eceeb8d834cfec',
+    )
+  })
+
+  it('should derive keys longer than a digest', () => {
+    expect(hex.encode(pbkdf2Sha512(password, salt, 2, 80))).toEqual(
+      'e1d9c16aa681708a45f5c7c4e215ceb66e011a2e9f0040713f18aefdb866d53c'
+      + 'f76cab2868a39b9f7840edce4fef5a82be67335c77a6068e04112754f27ccf4e'
+      + '473e311ad827b68945f4e2dddb204c78',
+    )
+  })
+})
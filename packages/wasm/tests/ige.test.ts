@@ -1,7 +1,14 @@
 import { hex } from '@fuman/utils'
 import { beforeAll, describe, expect, it } from 'vitest'
 
-import { __getWasm, ige256Decrypt, ige256Encrypt } from '../src/index.js'
+import {
+  __getWasm,
+  getStagingBuffers,
+  ige256Decrypt,
+  ige256DecryptInPlace,
+  ige256Encrypt,
+  ige256EncryptInPlace,
+} from '../src/index.js'
 
 import { initWasm } from './init.js'
 
@@ -28,6 +35,24 @@ describe('aes-ige', () => {
     expect(hex.encode(aes)).toEqual(hex.encode(data))
   })
 
+  it('should correctly encrypt and decrypt in place', () => {
+    const buf = data.slice()
+
+    ige256EncryptInPlace(buf, key, iv)
+    expect(hex.encode(buf)).toEqual(hex.encode(dataEnc))
+
+    ige256DecryptInPlace(buf, key, iv)
+    expect(hex.encode(buf)).toEqual(hex.encode(data))
+  })
+
+  it('should correctly encrypt in place inside wasm memory', () => {
+    const [buf] = getStagingBuffers(data.length, 0)
+    buf.set(data)
+
+    ige256EncryptInPlace(buf, key, iv)
+    expect(hex.encode(buf)).toEqual(hex.encode(dataEnc))
+  })
+
   it('should not leak memory', () => {
     const mem = __getWasm().memory.buffer
     const memSize = mem.byteLength
@@ -0,0 +1,84 @@
+import { hex } from '@fuman/utils'
+import { beforeAll, describe, expect, it } from 'vitest'
+
+import { __getWasm, modPow } from '../src/index.js'
+
+import { initWasm } from './init.js'
+
+beforeAll(async () => {
+  await initWasm()
+})
+
+describe('modPow', () => {
+  it('should calculate small powers', () => {
+    expect(hex.encode(modPow(hex.decode('04'), hex.decode('0d'), hex.decode('01f1')))).toEqual('01bd')
+  })
+
+  it('should reduce bases larger than the modulus', () => {
+    expect(hex.encode(modPow(hex.decode('123456'), hex.decode('01'), hex.decode('01f1')))).toEqual('00f6')
+  })
+
+  it('should return 1 for a zero exponent', () => {
+    expect(hex.encode(modPow(hex.decode('04'), new Uint8Array(0), hex.decode('01f1')))).toEqual('0001')
+  })
+
+  it('should calculate 512-bit powers', () => {
+    const mod = hex.decode(
+      'b8f12d92a28f17d83ce44e27424458b6b6043106a85f68b6daa8b2a668d605d4'
+      + '017f9ee6725ed09d3a0562d56abd685a48f165d57b00c7f4781ef86f5c8cc1ab',
+    )
+    const base = hex.decode(
+      'e4bf1505372ef440e5c51e9a508bb1f4c9da653868e6d9ca0bc36c05adb3fc4f'
+      + '6341279a23bef7be506564f3a160712456de76aaadd6b855c6b62bd09e04924d'
+      + '52bc614bedce030297c5e5',
+    )
+    const exp = hex.decode(
+      '4f4e68e5c85bd78d396e0d55fc45228f4bd571b0b41b5669a0729b23994395a7'
+      + '74f0147f76f87a640701ad82a1865506aadbf8319b25f81fcec1496e2769e927',
+    )
+
+    expect(hex.encode(modPow(base, exp, mod))).toEqual(
+      '2b15394782e9c6f0ad18d6f6cd9f15e4956b11597e276f82ee457ed391defab4'
+      + '70f7efa091761d5815f1e1ae1d33230d36544556aa4563e29a6ecb06f3da2fc4',
+    )
+  })
+
+  it('should calculate 4096-bit powers', () => {
+    const toBig = (buf: Uint8Array) => BigInt(`0x${hex.encode(buf)}`)
+    const mod = new Uint8Array(512).map((_, i) => (i * 37 + 11) & 0xFF)
+    mod[0] |= 0x80
+    mod[511] |= 1
+    const base = new Uint8Array(512).map((_, i) => (i * 91 + 7) & 0xFF)
+    const exp = new Uint8Array(512).map((_, i) => (i * 53 + 3) & 0xFF)
+
+    const m = toBig(mod)
+    let expected = 1n
+    let b = toBig(base) % m
+    for (let e = toBig(exp); e > 0n; e >>= 1n) {
+      if (e & 1n) expected = expected * b % m
+      b = b * b % m
+    }
+
+    expect(hex.encode(modPow(base, exp, mod))).toEqual(expected.toString(16).padStart(1024, '0'))
+  })
+
+  it('should ignore leading zeros of the exponent', () => {
+    expect(hex.encode(modPow(hex.decode('04'), hex.decode('0000000d'), hex.decode('01f1')))).toEqual('01bd')
+    expect(hex.encode(modPow(hex.decode('04'), new Uint8Array(256), hex.decode('01f1')))).toEqual('0001')
+  })
+
+  it('should throw on even moduli', () => {
+    expect(() => modPow(hex.decode('04'), hex.decode('0d'), hex.decode('01f2'))).toThrow(RangeError)
+  })
+
+  it('should not leak memory', () => {
+    const mem = __getWasm().memory.buffer
+    const memSize = mem.byteLength
+
+    for (let i = 0; i < 100; i++) {
+      modPow(hex.decode('04'), hex.decode('0d'), hex.decode('01f1'))
+    }
+
+    expect(mem.byteLength).toEqual(memSize)
+  })
+})
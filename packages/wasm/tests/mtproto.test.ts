@@ -0,0 +1,158 @@
+import { hex, u8 } from '@fuman/utils'
+import { beforeAll, describe, expect, it } from 'vitest'
+
+import {
+  __getWasm,
+  authKeyRegister,
+  authKeyRelease,
+  decryptMessage,
+  encryptMessage,
+  ige256Decrypt,
+  ige256Encrypt,
+  sha1,
+  sha256,
+} from '../src/index.js'
+
+import { initWasm } from './init.js'
+
+beforeAll(async () => {
+  await initWasm()
+})
+
+describe('mtproto', () => {
+  const authKey = new Uint8Array(256).map((_, i) => i * 13 + 7)
+  const serverSalt = { low: 0x11223344, high: 0x55667788 }
+  const sessionId = { low: -1, high: 0x01020304 }
+
+  // describe() bodies run before the wasm module is initialized
+  let authKeyId: Uint8Array
+  beforeAll(() => {
+    authKeyId = sha1(authKey).subarray(12, 20)
+  })
+
+  it('should encrypt messages compatibly with the MTProto 2.0 KDF', () => {
+    const authKeyHandle = authKeyRegister(authKey)
+    const message = new Uint8Array(123).map((_, i) => i)
+
+    const res = encryptMessage(authKeyHandle, message, serverSalt, sessionId, buf => buf.fill(0x42))
+    authKeyRelease(authKeyHandle)
+
+    expect(hex.encode(res.subarray(0, 8))).toEqual(hex.encode(authKeyId))
+    expect((res.length - 24) % 16).toEqual(0)
+
+    const messageKey = res.subarray(8, 24)
+    const sha256a = sha256(u8.concat2(messageKey, authKey.subarray(0, 36)))
+    const sha256b = sha256(u8.concat2(authKey.subarray(40, 76), messageKey))
+    const key = u8.concat3(sha256a.subarray(0, 8), sha256b.subarray(8, 24), sha256a.subarray(24, 32))
+    const iv = u8.concat3(sha256b.subarray(0, 8), sha256a.subarray(8, 24), sha256b.subarray(24, 32))
+
+    const plain = ige256Decrypt(res.subarray(24), key, iv)
+
+    expect(hex.encode(plain.subarray(0, 16))).toEqual('4433221188776655ffffffff04030201')
+    expect(hex.encode(plain.subarray(16, 16 + message.length))).toEqual(hex.encode(message))
+    expect(plain.subarray(16 + message.length).every(it => it === 0x42)).toBe(true)
+    const expectedKey = sha256(u8.concat2(authKey.subarray(88, 120), plain)).subarray(8, 24)
+    expect(hex.encode(messageKey)).toEqual(hex.encode(expectedKey))
+  })
+
+  function encryptServerMessage(plain: Uint8Array) {
+    const messageKey = sha256(u8.concat2(authKey.subarray(96, 128), plain)).subarray(8, 24)
+    const sha256a = sha256(u8.concat2(messageKey, authKey.subarray(8, 44)))
+    const sha256b = sha256(u8.concat2(authKey.subarray(48, 84), messageKey))
+    const key = u8.concat3(sha256a.subarray(0, 8), sha256b.subarray(8, 24), sha256a.subarray(24, 32))
+    const iv = u8.concat3(sha256b.subarray(0, 8), sha256a.subarray(8, 24), sha256b.subarray(24, 32))
+
+    return u8.concat3(authKeyId, messageKey, ige256Encrypt(plain, key, iv))
+  }
+
+  it('should decrypt and verify server messages', () => {
+    const authKeyHandle = authKeyRegister(authKey)
+    const plain = new Uint8Array(96).map((_, i) => i * 3)
+
+    let res: Uint8Array | undefined
+    const ok = decryptMessage(authKeyHandle, encryptServerMessage(plain), (data) => {
+      res = data.slice()
+    })
+    authKeyRelease(authKeyHandle)
+
+    expect(ok).toBe(true)
+    expect(hex.encode(res!)).toEqual(hex.encode(plain))
+  })
+
+  it('should ignore transport padding', () => {
+    const authKeyHandle = authKeyRegister(authKey)
+    const plain = new Uint8Array(64).map((_, i) => i)
+
+    let res: Uint8Array | undefined
+    const ok = decryptMessage(authKeyHandle, u8.concat2(encryptServerMessage(plain), new Uint8Array(7)), (data) => {
+      res = data.slice()
+    })
+    authKeyRelease(authKeyHandle)
+
+    expect(ok).toBe(true)
+    expect(hex.encode(res!)).toEqual(hex.encode(plain))
+  })
+
+  it('should keep the decrypted data intact when the callback calls into the module', () => {
+    const authKeyHandle = authKeyRegister(authKey)
+    const plain = new Uint8Array(96).map((_, i) => i * 5)
+
+    let res: Uint8Array | undefined
+    const ok = decryptMessage(authKeyHandle, encryptServerMessage(plain), (data) => {
+      sha256(new Uint8Array(64).fill(0xFF))
+      res = data.slice()
+    })
+    authKeyRelease(authKeyHandle)
+
+    expect(ok).toBe(true)
+    expect(hex.encode(res!)).toEqual(hex.encode(plain))
+  })
+
+  it('should reject messages with invalid msg_key', () => {
+    const authKeyHandle = authKeyRegister(authKey)
+    const data = encryptServerMessage(new Uint8Array(64))
+    data[10] ^= 1
+
+    const ok = decryptMessage(authKeyHandle, data, () => {
+      throw new Error('should not be called')
+    })
+    authKeyRelease(authKeyHandle)
+
+    expect(ok).toBe(false)
+  })
+
+  it('should throw on released handles', () => {
+    const authKeyHandle = authKeyRegister(authKey)
+    authKeyRelease(authKeyHandle)
+
+    expect(() => encryptMessage(authKeyHandle, new Uint8Array(16), serverSalt, sessionId, () => {})).toThrow()
+    expect(() => decryptMessage(authKeyHandle, encryptServerMessage(new Uint8Array(64)), () => {})).toThrow()
+  })
+
+  it('should reuse released handles', () => {
+    const handles = Array.from({ length: 20 }, () => authKeyRegister(authKey))
+    authKeyRelease(handles[5])
+
+    const handle = authKeyRegister(authKey)
+
+    expect(handle).toEqual(handles[5])
+
+    for (const it of handles) authKeyRelease(it)
+  })
+
+  it('should not leak memory', () => {
+    const authKeyHandle = authKeyRegister(authKey)
+    const message = new Uint8Array(1008)
+    const mem = __getWasm().memory.buffer
+    const memSize = mem.byteLength
+
+    for (let i = 0; i < 100; i++) {
+      encryptMessage(authKeyHandle, message, serverSalt, sessionId, buf => buf.fill(0))
+      decryptMessage(authKeyHandle, encryptServerMessage(message), () => {})
+    }
+
+    authKeyRelease(authKeyHandle)
+
+    expect(mem.byteLength).toEqual(memSize)
+  })
+})
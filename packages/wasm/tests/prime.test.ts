@@ -0,0 +1,58 @@
+import { bigint } from '@fuman/utils'
+import { beforeAll, describe, expect, it, vi } from 'vitest'
+
+import { isProbablePrime } from '../src/index.js'
+
+import { initWasm } from './init.js'
+
+beforeAll(async () => {
+  await initWasm()
+})
+
+describe('isProbablePrime', () => {
+  const randomFill = (buf: Uint8Array) => {
+    for (let i = 0; i < buf.length; i++) buf[i] = Math.floor(Math.random() * 256)
+  }
+  const check = (n: bigint) => isProbablePrime(bigint.toBytes(n), randomFill)
+
+  it('should handle small numbers', () => {
+    for (const n of [2n, 3n, 5n, 17n]) {
+      expect(check(n)).toBe(true)
+    }
+
+    for (const n of [0n, 1n, 4n, 9n, 15n]) {
+      expect(check(n)).toBe(false)
+    }
+  })
+
+  it('should label carmichael numbers and strong pseudoprimes as composite', () => {
+    for (const n of [561n, 1105n, 2047n, 3215031751n, 341550071728321n]) {
+      expect(check(n)).toBe(false)
+    }
+  })
+
+  it('should label large primes as probable primes', () => {
+    expect(check(2n ** 127n - 1n)).toBe(true)
+    expect(check(2n ** 521n - 1n)).toBe(true)
+    expect(check(2n ** 523n - 1n)).toBe(false)
+  })
+
+  it('should cache primes', () => {
+    const fill = vi.fn(randomFill)
+    const n = bigint.toBytes(2n ** 607n - 1n)
+
+    expect(isProbablePrime(n, fill)).toBe(true)
+    expect(isProbablePrime(n, fill)).toBe(true)
+    expect(fill).toHaveBeenCalledOnce()
+  })
+
+  it('should not reuse results cached with fewer rounds', () => {
+    const fill = vi.fn(randomFill)
+    const n = bigint.toBytes(2n ** 1279n - 1n)
+
+    expect(isProbablePrime(n, fill, 1)).toBe(true)
+    expect(isProbablePrime(n, fill, 20)).toBe(true)
+    expect(isProbablePrime(n, fill, 10)).toBe(true)
+    expect(fill.mock.calls.length).toEqual(2)
+  })
+})
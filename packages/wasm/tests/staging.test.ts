@@ -0,0 +1,139 @@
+import { hex, utf8 } from '@fuman/utils'
+import { beforeAll, describe, expect, it } from 'vitest'
+
+import {
+  __getWasm,
+  createCtr256,
+  ctr256Into,
+  deflateMaxSize,
+  deflateMaxSizeInto,
+  freeCtr256,
+  getStagingBuffers,
+  gunzip,
+  getWasmStats,
+  gunzipInto,
+  ige256DecryptInto,
+  ige256Encrypt,
+  ige256EncryptInto,
+  sha1,
+  sha1Into,
+  sha256,
+  sha256Into,
+} from '../src/index.js'
+
+import { initWasm } from './init.js'
+
+beforeAll(async () => {
+  await initWasm()
+})
+
+describe('staging', () => {
+  const key = hex.decode('5468697320697320616E20696D706C655468697320697320616E20696D706C65')
+  const iv = hex.decode('6D656E746174696F6E206F6620494745206D6F646520666F72204F70656E5353')
+
+  const data = hex.decode('99706487a1cde613bc6de0b6f24b1c7aa448c8b9c3403e3467a8cad89340f53b')
+  const dataEnc = hex.decode('792ea8ae577b1a66cb3bd92679b8030ca54ee631976bd3a04547fdcb4639fa69')
+
+  it('should write into caller-provided buffers', () => {
+    const out = new Uint8Array(64)
+
+    ige256EncryptInto(data, key, iv, out)
+    expect(hex.encode(out.subarray(0, 32))).toEqual(hex.encode(dataEnc))
+
+    ige256DecryptInto(dataEnc, key, iv, out.subarray(32))
+    expect(hex.encode(out.subarray(32))).toEqual(hex.encode(data))
+
+    sha256Into(data, out)
+    expect(out.subarray(0, 32)).toEqual(sha256(data))
+
+    sha1Into(data, out.subarray(40))
+    expect(out.subarray(40, 60)).toEqual(sha1(data))
+  })
+
+  it('should work in place on staging buffers', () => {
+    const [input, output] = getStagingBuffers(32, 32)
+    expect(input.buffer).toBe(__getWasm().memory.buffer)
+
+    input.set(data)
+    ige256EncryptInto(input, key, iv, output)
+    expect(hex.encode(output)).toEqual(hex.encode(dataEnc))
+
+    sha256Into(input, output)
+    expect(output).toEqual(sha256(data))
+  })
+
+  it('should produce the same results for ctr', () => {
+    const buf = new Uint8Array(1000).map((_, i) => i)
+
+    const ctx1 = createCtr256(key.subarray(0, 32), iv.subarray(0, 16))
+    const expected = new Uint8Array(1000)
+    ctr256Into(ctx1, buf, expected)
+    freeCtr256(ctx1)
+
+    const ctx2 = createCtr256(key.subarray(0, 32), iv.subarray(0, 16))
+    const [input, output] = getStagingBuffers(1000, 1000)
+    input.set(buf)
+    ctr256Into(ctx2, input, output)
+    freeCtr256(ctx2)
+
+    expect(output).toEqual(expected)
+  })
+
+  it('should deflate and gunzip into buffers', () => {
+    const text = utf8.encoder.encode(Array.from({ length: 1000 }, () => 'a').join(''))
+
+    const out = new Uint8Array(100)
+    const written = deflateMaxSizeInto(text, out)
+
+    expect(written).toBeGreaterThan(0)
+    expect(out.subarray(0, written)).toEqual(deflateMaxSize(text, 100))
+    expect(deflateMaxSizeInto(text, new Uint8Array(1))).toEqual(0)
+
+    // gzip of 'hello world'
+    const gzipped = hex.decode('1f8b0800000000000203cb48cdc9c95728cf2fca49010085114a0d0b000000')
+    const plain = new Uint8Array(11)
+
+    expect(gunzipInto(gzipped, plain)).toEqual(11)
+    expect(plain).toEqual(gunzip(gzipped))
+    expect(utf8.decoder.decode(plain)).toEqual('hello world')
+  })
+
+  it('should throw if the output buffer is too small', () => {
+    expect(() => ige256EncryptInto(data, key, iv, new Uint8Array(16))).toThrow(RangeError)
+    expect(() => sha256Into(data, new Uint8Array(20))).toThrow(RangeError)
+  })
+
+  it('should not allocate on every call', () => {
+    const memSize = __getWasm().memory.buffer.byteLength
+    ige256Encrypt(data, key, iv)
+
+    const wasm = __getWasm()
+    const ptr = wasm.__malloc(16)
+    wasm.__free(ptr)
+
+    for (let i = 0; i < 1000; i++) {
+      ige256Encrypt(data, key, iv)
+      sha256(data)
+    }
+
+    expect(wasm.__malloc(16)).toEqual(ptr)
+    wasm.__free(ptr)
+    expect(wasm.memory.buffer.byteLength).toEqual(memSize)
+  })
+
+  it('should release large scratch areas', async () => {
+    sha256(data)
+    const before = getWasmStats().liveBytes
+
+    sha256(new Uint8Array(4 * 1024 * 1024))
+    expect(getWasmStats().liveBytes).toBeGreaterThan(before + 1024 * 1024)
+
+    await Promise.resolve()
+    expect(getWasmStats().liveBytes).toBeLessThanOrEqual(before)
+  })
+
+  it('should throw if WASM memory can not be allocated', () => {
+    expect(() => deflateMaxSize(data, 0x7FFFFFFF)).toThrow(RangeError)
+    expect(sha256(data)).toEqual(sha256(data.slice()))
+  })
+})
@@ -3,7 +3,19 @@ import { inflateSync } from 'node:zlib'
 import { utf8 } from '@fuman/utils'
 import { beforeAll, describe, expect, it } from 'vitest'
 
-import { __getWasm, deflateMaxSize } from '../src/index.js'
+import {
+  __getWasm,
+  createDeflate,
+  deflateChunksMaxSize,
+  deflateFinish,
+  deflateMaxSize,
+  deflatePullInto,
+  deflatePush,
+  estimateCompressibility,
+  freeDeflate,
+  gzipPacked,
+  gzipPackedInto,
+} from '../src/index.js'
 
 import { initWasm } from './init.js'
 
@@ -24,12 +36,35 @@ function inflateSyncWrap(data: Uint8Array) {
 
 describe('zlib deflate', () => {
   it('should add zlib headers', () => {
-    const res = deflateMaxSize(utf8.encoder.encode('hello world'), 100)
+    const res = deflateMaxSize(utf8.encoder.encode('hello world'), 100, { level: 6 })
 
     expect(res).not.toBeNull()
     expect(res!.slice(0, 2)).toEqual(new Uint8Array([0x78, 0x9C]))
   })
 
+  it('should choose compression level based on size', () => {
+    const small = deflateMaxSize(utf8.encoder.encode('hello world'), 100)
+    const large = new Uint8Array(300 * 1024)
+    const largeRes = deflateMaxSize(large, 1000)
+
+    // FLEVEL in the zlib header: fastest and slowest respectively
+    expect(small!.slice(0, 2)).toEqual(new Uint8Array([0x78, 0x01]))
+    expect(largeRes!.slice(0, 2)).toEqual(new Uint8Array([0x78, 0xDA]))
+    expect(new Uint8Array(inflateSyncWrap(largeRes!))).toEqual(large)
+  })
+
+  it('should support all compression levels', () => {
+    const data = utf8.encoder.encode(Array.from({ length: 1000 }, (_, i) => `item ${i % 97}, `).join(''))
+
+    for (let level = 0; level <= 12; level++) {
+      const res = deflateMaxSize(data, data.length + 100, { level })
+
+      expect(new Uint8Array(inflateSyncWrap(res!))).toEqual(data)
+    }
+
+    expect(() => deflateMaxSize(data, 100, { level: 13 })).toThrow(RangeError)
+  })
+
   it('should return null if compressed data is larger than size', () => {
     const res = deflateMaxSize(utf8.encoder.encode('hello world'), 1)
 
@@ -60,3 +95,123 @@ describe('zlib deflate', () => {
     expect(__getWasm().memory.buffer.byteLength).toEqual(memSize)
   })
 })
+
+describe('estimateCompressibility', () => {
+  it('should detect incompressible data', () => {
+    // xorshift32 output does not compress
+    const data = new Uint8Array(65536)
+    let x = 0x12345678
+    for (let i = 0; i < data.length; i++) {
+      x ^= x << 13
+      x ^= x >>> 17
+      x ^= x << 5
+      data[i] = x & 0xFF
+    }
+
+    expect(estimateCompressibility(data)).toBeGreaterThan(0.95)
+    expect(estimateCompressibility(data.subarray(0, 3))).toEqual(1)
+  })
+
+  it('should detect compressible data', () => {
+    const text = utf8.encoder.encode(Array.from({ length: 5000 }, (_, i) => `item ${i % 97}, `).join(''))
+
+    expect(estimateCompressibility(text)).toBeLessThan(0.5)
+    expect(estimateCompressibility(new Uint8Array(65536))).toBeLessThan(0.05)
+  })
+})
+
+describe('zlib deflate streaming', () => {
+  const text = utf8.encoder.encode(Array.from({ length: 30000 }, (_, i) => `item ${i % 997}, `).join(''))
+
+  it('should deflate chunks', () => {
+    const chunks = [text.subarray(0, 1), text.subarray(1, 100000), text.subarray(100000)]
+    const res = deflateChunksMaxSize(chunks, text.length, { level: 6 })
+
+    expect(res).not.toBeNull()
+    expect(res!.slice(0, 2)).toEqual(new Uint8Array([0x78, 0x9C]))
+    expect(new Uint8Array(inflateSyncWrap(res!))).toEqual(text)
+    expect(deflateChunksMaxSize([], 100)).not.toBeNull()
+  })
+
+  it('should return null if the output is too large', () => {
+    expect(deflateChunksMaxSize([text], 100)).toBeNull()
+  })
+
+  it('should support pushing and pulling manually', () => {
+    const ctx = createDeflate()
+    const out = new Uint8Array(text.length)
+    let outPos = 0
+    let inPos = 0
+
+    while (inPos < text.length) {
+      inPos += deflatePush(ctx, text.subarray(inPos, inPos + 10000))
+      outPos += deflatePullInto(ctx, out.subarray(outPos, outPos + 1000))
+    }
+
+    deflateFinish(ctx)
+
+    for (;;) {
+      const written = deflatePullInto(ctx, out.subarray(outPos, outPos + 1000))
+      if (written === 0) break
+      outPos += written
+    }
+
+    freeDeflate(ctx)
+
+    expect(new Uint8Array(inflateSyncWrap(out.subarray(0, outPos)))).toEqual(text)
+  })
+})
+
+describe('gzip_packed', () => {
+  function unpack(obj: Uint8Array) {
+    const view = new DataView(obj.buffer, obj.byteOffset, obj.byteLength)
+    expect(view.getUint32(0, true)).toEqual(0x3072CFA1)
+    expect(obj.length % 4).toEqual(0)
+
+    let length = obj[4]
+    let offset = 5
+    if (length === 254) {
+      length = view.getUint32(4, true) >>> 8
+      offset = 8
+    }
+
+    expect(obj.length - offset - length).toBeLessThan(4)
+    expect(obj.subarray(offset + length).every(it => it === 0)).toBe(true)
+
+    return new Uint8Array(inflateSyncWrap(obj.slice(offset, offset + length)))
+  }
+
+  it('should serialize with a short length', () => {
+    const data = new Uint8Array(1000).fill(0x61)
+    const res = gzipPacked(data, 1000)
+
+    expect(res).not.toBeNull()
+    expect(res![4]).toBeLessThan(254)
+    expect(unpack(res!)).toEqual(data)
+  })
+
+  it('should serialize with a long length', () => {
+    const text = utf8.encoder.encode(Array.from({ length: 5000 }, (_, i) => `item ${i % 997}, `).join(''))
+    const res = gzipPacked(text, text.length)
+
+    expect(res).not.toBeNull()
+    expect(res![4]).toEqual(254)
+    expect(unpack(res!)).toEqual(text)
+  })
+
+  it('should write into a buffer', () => {
+    const data = new Uint8Array(1000).fill(0x61)
+    const out = new Uint8Array(100).fill(0xFF)
+    const written = gzipPackedInto(data, out.subarray(4))
+
+    expect(written).toBeGreaterThan(0)
+    expect(out.subarray(0, 4)).toEqual(new Uint8Array([0xFF, 0xFF, 0xFF, 0xFF]))
+    expect(unpack(out.subarray(4, 4 + written))).toEqual(data)
+    expect(out[4 + written]).toEqual(0xFF)
+  })
+
+  it('should return null if the object is larger than size', () => {
+    expect(gzipPacked(utf8.encoder.encode('hello world'), 16)).toBeNull()
+    expect(gzipPackedInto(utf8.encoder.encode('hello world'), new Uint8Array(16))).toEqual(0)
+  })
+})
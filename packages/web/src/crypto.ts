@@ -4,15 +4,25 @@ import { BaseCryptoProvider } from '@mtcute/core/utils.js'
 
 import {
   createCtr256,
+  createHmacSha256,
   ctr256,
   deflateMaxSize,
+  estimateCompressibility,
+  factorizePQ,
   freeCtr256,
+  freeHmacSha256,
   gunzip,
+  hasWasmExport,
+  hmacSha256,
   ige256Decrypt,
   ige256Encrypt,
   initSync,
+  isProbablePrime,
+  modPow,
+  pbkdf2Sha512,
   sha1,
   sha256,
+  sha256v,
 } from '@mtcute/wasm'
 import { loadWasmBinary } from './wasm.js'
 
@@ -30,6 +40,15 @@ export interface WebCryptoProviderOptions {
 export class WebCryptoProvider extends BaseCryptoProvider implements ICryptoProvider {
   readonly crypto: Crypto
   private _wasmInput?: WasmInitInput
+  private _wasmHmac = false
+  private _wasmPbkdf2 = false
+  private _wasmFactorize = false
+
+  // optional methods backed by newer exports, only set up in `initialize` if the module has them
+  sha256Multi?: (parts: Uint8Array[]) => Uint8Array
+  modPow?: (base: Uint8Array, exp: Uint8Array, mod: Uint8Array) => Uint8Array
+  isProbablePrime?: (n: Uint8Array, rounds: number) => boolean
+  estimateCompressibility?: (data: Uint8Array) => number
 
   sha1(data: Uint8Array): Uint8Array {
     return sha1(data)
@@ -55,6 +74,12 @@ export class WebCryptoProvider extends BaseCryptoProvider implements ICryptoProv
     }
   }
 
+  protected factorizePQNative(pq: Uint8Array): [Uint8Array, Uint8Array] | null {
+    if (!this._wasmFactorize) return null
+
+    return factorizePQ(pq)
+  }
+
   gzip(data: Uint8Array, maxSize: number): Uint8Array | null {
     return deflateMaxSize(data, maxSize)
   }
@@ -76,14 +101,41 @@ export class WebCryptoProvider extends BaseCryptoProvider implements ICryptoProv
 
   async initialize(): Promise<void> {
     initSync(await loadWasmBinary(this._wasmInput))
+
+    // `wasmInput` may point to an older build of the module, so newer exports are only used if they're there
+    this._wasmHmac = hasWasmExport('hmac_sha256_alloc')
+    this._wasmPbkdf2 = hasWasmExport('pbkdf2_sha512')
+    this._wasmFactorize = hasWasmExport('factorize_pq')
+
+    if (hasWasmExport('sha256_iov')) this.sha256Multi = sha256v
+    if (hasWasmExport('modpow')) this.modPow = modPow
+    if (hasWasmExport('is_probable_prime')) {
+      this.isProbablePrime = (n, rounds) => isProbablePrime(n, buf => this.randomFill(buf), rounds)
+    }
+    if (hasWasmExport('estimate_compressibility')) this.estimateCompressibility = estimateCompressibility
   }
 
-  async pbkdf2(
+  pbkdf2(
     password: Uint8Array,
     salt: Uint8Array,
     iterations: number,
     keylen?: number | undefined,
     algo?: string | undefined,
+  ): Uint8Array | Promise<Uint8Array> {
+    // used for 2fa passwords, avoid the async round trip to crypto.subtle
+    if (this._wasmPbkdf2 && (algo === undefined || algo === 'sha512')) {
+      return pbkdf2Sha512(password, salt, iterations, keylen || 64)
+    }
+
+    return this._pbkdf2Subtle(password, salt, iterations, keylen, algo ?? 'sha512')
+  }
+
+  private async _pbkdf2Subtle(
+    password: Uint8Array,
+    salt: Uint8Array,
+    iterations: number,
+    keylen: number | undefined,
+    algo: string,
   ): Promise<Uint8Array> {
     const keyMaterial = await this.crypto.subtle.importKey('raw', password as Uint8Array<ArrayBuffer>, 'PBKDF2', false, ['deriveBits'])
 
@@ -93,7 +145,7 @@ export class WebCryptoProvider extends BaseCryptoProvider implements ICryptoProv
           name: 'PBKDF2',
           salt: salt as Uint8Array<ArrayBuffer>,
           iterations,
-          hash: algo ? ALGO_TO_SUBTLE[algo] : 'SHA-512',
+          hash: ALGO_TO_SUBTLE[algo],
         },
         keyMaterial,
         (keylen || 64) * 8,
@@ -101,7 +153,19 @@ export class WebCryptoProvider extends BaseCryptoProvider implements ICryptoProv
       .then(result => new Uint8Array(result))
   }
 
-  async hmacSha256(data: Uint8Array, key: Uint8Array): Promise<Uint8Array> {
+  hmacSha256(data: Uint8Array, key: Uint8Array): Uint8Array | Promise<Uint8Array> {
+    if (!this._wasmHmac) return this._hmacSha256Subtle(data, key)
+
+    const ctx = createHmacSha256(key)
+
+    try {
+      return hmacSha256(ctx, data)
+    } finally {
+      freeHmacSha256(ctx)
+    }
+  }
+
+  private async _hmacSha256Subtle(data: Uint8Array, key: Uint8Array): Promise<Uint8Array> {
     const keyMaterial = await this.crypto.subtle.importKey(
       'raw',
       key as Uint8Array<ArrayBuffer>,